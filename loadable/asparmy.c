@@ -0,0 +1,37 @@
+/**
+ * \file asparmy.c
+ * Spawns all arguments through the launch queues.
+ *
+ **/
+#include "../loadtheone/loader_api.h"
+
+/** \brief Queues all arguments for loading, returns 0.
+ * \param argc nr of args
+ * \param argv arguments, a list of ELF filenames
+ * \param env Environment, passed on
+ * \param api API interface, used for the load_async function
+ * \return zero
+ * */
+int lmain(int argc, char **argv, char *env, struct loader_api_s *api){
+  if (! (argc && argv && api)) return 0;
+  struct admin_s cld;
+
+  /*clients arugments array*/
+  char *runargv[] = {""};
+  int i;
+
+  for (i=1; i<argc; i++){
+    /* Only enqueues, the loader cores do the loading */
+    ZERO_ADMINP(&cld);
+    cld.verbose = 0;
+    cld.settings = e_timeit;
+    cld.core_start = -1;
+    cld.core_size = 1;
+    cld.argv = runargv;
+    cld.argc = 0;
+    cld.fname = argv[i];
+    cld.envp = env;
+    api->load_async(&cld, 0);
+  }
+  return 0;
+}
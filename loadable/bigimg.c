@@ -0,0 +1,24 @@
+/**
+ * \file bigimg.c
+ * Carries a large initialized image, for timing the load of big files.
+ *
+ **/
+
+#include "../loadtheone/loader_api.h"
+
+/** Bytes of initialized data in the image */
+#define BLOBSIZE (1 << 20)
+
+/** Initialized, so all of it is in the file and copied on load */
+static char blob[BLOBSIZE] = {1};
+
+/** \brief Reads the image, returns 0.
+ * \param argc nr of args, used as index
+ * \param argv arguments, unused
+ * \param env Environment, unused
+ * \param api API interface, unused
+ * \return zero
+ * */
+int lmain(int argc, char **argv, char *env, struct loader_api_s *api){
+  return blob[0] - 1 + blob[BLOBSIZE - 1 - argc];
+}
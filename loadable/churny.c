@@ -0,0 +1,42 @@
+/**
+ * \file churny.c
+ * Loads its first argument over and over, waiting for each, so pids are
+ * handed out and released back to back.
+ *
+ **/
+#include "../loadtheone/loader_api.h"
+
+/** Number of loads */
+#define ROUNDS 128
+
+/** \brief Loads and reaps argv[1] ROUNDS times.
+ * \param argc nr of args
+ * \param argv arguments, an ELF filename
+ * \param env Environment, passed on
+ * \param api API interface, used for spawn,wait functions
+ * \return number of loads that failed
+ * */
+int lmain(int argc, char **argv, char *env, struct loader_api_s *api){
+  if (! (argc > 1 && argv && api)) return 0;
+  struct admin_s cld;
+  loader_handle_t h;
+
+  /*clients arugments array*/
+  char *runargv[] = {""};
+  int i;
+  int failed = 0;
+
+  for (i=0; i<ROUNDS; i++){
+    ZERO_ADMINP(&cld);
+    cld.settings = e_timeit | e_joinable;
+    cld.core_start = -1;
+    cld.core_size = 1;
+    cld.argv = runargv;
+    cld.argc = 0;
+    cld.fname = argv[1];
+    cld.envp = env;
+    h = api->load_fromparam(&cld, 0);
+    if (!h || api->wait(h, 0, 0)) failed++;
+  }
+  return failed;
+}
@@ -0,0 +1,51 @@
+/**
+ * \file heapy.c
+ * Builds a list on the loader heap, sums it and frees it again.
+ *
+ **/
+#include "../loadtheone/loader_api.h"
+
+/** Number of list nodes */
+#define NODES 1000
+
+/** List node */
+struct node_s {
+  /** Next node */
+  struct node_s *next;
+  /** Payload */
+  int val;
+};
+
+/** \brief Allocates, walks and frees a list through the loader heap.
+ * \param argc nr of args
+ * \param argv arguments, unused
+ * \param env Environment, unused
+ * \param api API interface, used for print and heap functions
+ * \return 0 if the sum matches, 1 otherwise
+ * */
+int lmain(int argc, char **argv, char *env, struct loader_api_s *api){
+  if (! api) return 0;
+  struct node_s *head = NULL;
+  struct node_s *n;
+  int i;
+  int sum = 0;
+
+  for (i=0;i<NODES;i++){
+    n = api->malloc(api, sizeof(struct node_s));
+    if (!n) break;
+    n->val = i;
+    n->next = head;
+    head = n;
+  }
+  while (head){
+    n = head->next;
+    sum += head->val;
+    api->free(api, head);
+    head = n;
+  }
+
+  api->print_string("<Heap>", PRINTOUT);
+  api->print_int(sum, PRINTOUT);
+  api->print_string("</Heap>\n", PRINTOUT);
+  return (sum == (NODES * (NODES - 1)) / 2) ? 0 : 1;
+}
@@ -0,0 +1,57 @@
+/**
+ * \file joiny.c
+ * Spawns all arguments as joinable, waits for them, prints the exit codes.
+ *
+ **/
+#include "../loadtheone/loader_api.h"
+
+/** Maximum number of waited for programs */
+#define MAXKIDS 256
+
+/** \brief Starts all arguments, reaps them.
+ * \param argc nr of args
+ * \param argv arguments, a list of ELF filenames
+ * \param env Environment, passed on
+ * \param api API interface, used for print,spawn,wait functions
+ * \return number of children that could not be reaped
+ * */
+int lmain(int argc, char **argv, char *env, struct loader_api_s *api){
+  if (! (argc && argv && api)) return 0;
+  struct admin_s cld;
+  loader_handle_t kids[MAXKIDS];
+  int codes[MAXKIDS];
+
+  /*clients arugments array*/
+  char *runargv[] = {""};
+  int i;
+  int n = 0;
+  int left;
+  void (*output_string)(const char *, int) = api->print_string;
+  void (*output_int)(int, int) = api->print_int;
+
+  for (i=1; (i<argc) && (n < MAXKIDS); i++){
+    ZERO_ADMINP(&cld);
+    cld.settings = e_timeit | e_joinable;
+    cld.core_start = 64 + (n%64);
+    cld.core_size = 1;
+    cld.argv = runargv;
+    cld.argc = 0;
+    cld.fname = argv[i];
+    cld.envp = env;
+    kids[n] = api->load_fromparam(&cld, 0);
+    codes[n] = 0;
+    if (kids[n]) n++;
+  }
+
+  /* Blocks until all are reaped */
+  left = n - api->wait_many(kids, n, codes, 0);
+
+  for (i=0; i<n; i++){
+    output_string("<Exit>", PRINTOUT);
+    output_int(i, PRINTOUT);
+    output_string(",", PRINTOUT);
+    output_int(codes[i], PRINTOUT);
+    output_string("</Exit>\n", PRINTOUT);
+  }
+  return left;
+}
@@ -0,0 +1,76 @@
+/**
+ * \file keepy.c
+ * Runs all arguments, keeping a fixed number of them running at any time.
+ *
+ **/
+#include "../loadtheone/loader_api.h"
+
+/** How many programs to keep running */
+#define KEEP 8
+
+/** Completion queue, filled by the children */
+struct loader_cq_s cq;
+
+/** Drained records */
+struct loader_completion_s recs[KEEP];
+
+/** \brief Starts all arguments, refilling as children terminate.
+ * \param argc nr of args
+ * \param argv arguments, a list of ELF filenames
+ * \param env Environment, passed on
+ * \param api API interface, used for print,load_fromparam,cq functions
+ * \return zero
+ * */
+int lmain(int argc, char **argv, char *env, struct loader_api_s *api){
+  if (! (argc && argv && api)) return 0;
+  struct admin_s cld;
+
+  /*clients arugments array*/
+  char *runargv[] = {""};
+  int next = 1;
+  int running = 0;
+  int i;
+  void (*output_string)(const char *, int) = api->print_string;
+  void (*output_int)(int, int) = api->print_int;
+
+  api->cq_init(&cq);
+  while ((next < argc) || (running > 0)){
+    /* Fill up to KEEP */
+    while ((running < KEEP) && (next < argc)){
+      ZERO_ADMINP(&cld);
+      cld.settings = e_timeit;
+      cld.core_start = 64 + (next%64);
+      cld.core_size = 1;
+      cld.argv = runargv;
+      cld.argc = 0;
+      cld.fname = argv[next];
+      cld.envp = env;
+      cld.cq = &cq;
+      if (api->load_fromparam(&cld, 0)) running++;
+      next++;
+    }
+    if (running > 0){
+      /* Waits for at least one to terminate, a wait may run out empty */
+      int n = api->cq_drain(&cq, recs, KEEP, 0);
+      if (n < 0){
+        /* Terminated, but their records did not fit, the cores are free */
+        output_string("<Lost>", PRINTOUT);
+        output_int(-n, PRINTOUT);
+        output_string("</Lost>\n", PRINTOUT);
+        running += n;
+        continue;
+      }
+      for (i=0; i<n; i++){
+        output_string("<Done>", PRINTOUT);
+        output_int(recs[i].pidnum, PRINTOUT);
+        output_string(",", PRINTOUT);
+        output_int(recs[i].exit_code, PRINTOUT);
+        output_string(",", PRINTOUT);
+        output_int(recs[i].cleaneduptick - recs[i].createtick, PRINTOUT);
+        output_string("</Done>\n", PRINTOUT);
+      }
+      running -= n;
+    }
+  }
+  return 0;
+}
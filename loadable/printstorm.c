@@ -0,0 +1,28 @@
+/**
+ * \file printstorm.c
+ * Prints many short lines, for timing the contention on the print place.
+ *
+ **/
+
+#include "../loadtheone/loader_api.h"
+
+/** Lines printed */
+#define LINES 256
+
+/** \brief Prints LINES lines, returns 0.
+ * \param argc nr of args, unused
+ * \param argv arguments, unused
+ * \param env Environment, unused
+ * \param api API interface, used for print functions
+ * \return zero
+ * */
+int lmain(int argc, char **argv, char *env, struct loader_api_s *api){
+  int i;
+
+  for (i=0; i<LINES; i++){
+    api->print_string("<Storm>", PRINTOUT);
+    api->print_int(i, PRINTOUT);
+    api->print_string("</Storm>\n", PRINTOUT);
+  }
+  return 0;
+}
@@ -0,0 +1,39 @@
+/**
+ * \file relocy.c
+ * Carries a large table of pointers, each needing a relocation on load.
+ *
+ **/
+
+#include "../loadtheone/loader_api.h"
+
+/** Pointed to by every entry of the table */
+static int target = 0;
+
+/** Entries of the table, built up in powers of four */
+#define P1 &target
+/** 4 entries */
+#define P4 P1, P1, P1, P1
+/** 16 entries */
+#define P16 P4, P4, P4, P4
+/** 64 entries */
+#define P64 P16, P16, P16, P16
+/** 256 entries */
+#define P256 P64, P64, P64, P64
+/** 1024 entries */
+#define P1024 P256, P256, P256, P256
+/** 4096 entries */
+#define P4096 P1024, P1024, P1024, P1024
+
+/** The table, relocated by the loader */
+static int *table[] = { P4096 };
+
+/** \brief Reads the table, returns 0.
+ * \param argc nr of args, used as index
+ * \param argv arguments, unused
+ * \param env Environment, unused
+ * \param api API interface, unused
+ * \return zero
+ * */
+int lmain(int argc, char **argv, char *env, struct loader_api_s *api){
+  return *table[argc];
+}
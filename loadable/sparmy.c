@@ -49,11 +49,12 @@ int lmain(int argc, char **argv, char *env, struct loader_api_s *api){
   int i;
   void (*output_string)(const char *, int) = api->print_string;
 
-  int (*s)(struct admin_s *, enum e_settings);
+  loader_handle_t (*s)(struct admin_s *, enum e_settings);
   /* The spawn function */
   s = api->load_fromparam;
 
   /*Call */
+  ZERO_ADMINP(&cld);
   cld.verbose=0;
   cld.settings = 0;
   cld.core_start = 64;
@@ -69,8 +70,10 @@ int lmain(int argc, char **argv, char *env, struct loader_api_s *api){
 
     /*Call 'things' with args as specced */
     cld.verbose=0;
-    cld.settings = e_timeit;
-    cld.core_start = 64 + (i%64);
+    /* Equal args for all, none writes them */
+    cld.settings = e_timeit | e_sharedargs;
+    /* Any core, the loader spreads them over the least loaded */
+    cld.core_start = -1;
     cld.core_size = 1;
     cld.argv = runargv; 
     cld.argc = 0;
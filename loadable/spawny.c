@@ -20,7 +20,7 @@ int lmain(int argc, char **argv, char *env, struct loader_api_s *api){
   if (argc != 2) return 0;
 
   void (*output_string)(const char *, int) = api->print_string;
-  int (*s)(struct admin_s *, enum e_settings);
+  loader_handle_t (*s)(struct admin_s *, enum e_settings);
 
   //Find the 'counter' somethere
   int val = argv[1][0] - 'a';
@@ -40,6 +40,7 @@ int lmain(int argc, char **argv, char *env, struct loader_api_s *api){
 
     argv[1][0]++;
     /*Call 'me' with other args*/
+    ZERO_ADMINP(&cld);
     cld.verbose=0;
     cld.fname = argv[0];
     cld.core_start = 0;
@@ -47,6 +48,7 @@ int lmain(int argc, char **argv, char *env, struct loader_api_s *api){
     cld.argc = argc;
     cld.argv = argv;
     cld.envp = env;
+    /*Children count on their own copy of argv[1]*/
     (*s)(&cld,0);
     (*s)(&cld,0);
   }
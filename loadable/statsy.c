@@ -0,0 +1,133 @@
+/**
+ * \file statsy.c
+ * Spawns all arguments as joinable, samples the loader statistics while they
+ * run and once all are reaped, lists the processes while they run.
+ *
+ **/
+#include "../loadtheone/loader_api.h"
+
+/** Maximum number of waited for programs */
+#define MAXKIDS 256
+
+/** Maximum number of listed processes */
+#define MAXLIST 64
+
+/** Names of the relocation counters, as loader_stats_s.relocs */
+static const char *relocnames[STATS_RELOCTYPES] = {
+  "GlobDat", "Relative", "JmpSlot", "Other"
+};
+
+/** \brief Prints one counter as name=value.
+ * \param api API interface.
+ * \param name Counter name.
+ * \param val Counter value.
+ * */
+static void print_counter(struct loader_api_s *api, const char *name,
+                          unsigned long val){
+  api->print_string(name, PRINTOUT);
+  api->print_string("=", PRINTOUT);
+  api->print_int((int)val, PRINTOUT);
+  api->print_string(",", PRINTOUT);
+}
+
+/** \brief Prints a sample as a single <Stats> line.
+ * \param api API interface.
+ * \param when Label of the sample.
+ * */
+static void print_stats(struct loader_api_s *api, const char *when){
+  struct loader_stats_s st;
+  int i;
+
+  api->stats(&st);
+  api->print_string("<Stats>", PRINTOUT);
+  api->print_string(when, PRINTOUT);
+  api->print_string(",", PRINTOUT);
+  print_counter(api, "LoadsStarted", st.loads_started);
+  print_counter(api, "LoadsFailed", st.loads_failed);
+  print_counter(api, "BytesRead", st.bytes_read);
+  print_counter(api, "BytesCopied", st.bytes_copied);
+  print_counter(api, "BytesZeroed", st.bytes_zeroed);
+  print_counter(api, "PagesMapped", st.pages_mapped);
+  print_counter(api, "PagesUnmapped", st.pages_unmapped);
+  print_counter(api, "BytesRequested", st.bytes_requested);
+  print_counter(api, "BytesReserved", st.bytes_reserved);
+  print_counter(api, "BytesMapped", st.bytes_mapped);
+  print_counter(api, "MappedHighWater", st.bytes_mapped_highwater);
+  for (i=0; i<STATS_RELOCTYPES; i++){
+    print_counter(api, relocnames[i], st.relocs[i]);
+  }
+  print_counter(api, "Symbols", st.symbols);
+  print_counter(api, "Prints", st.prints);
+  print_counter(api, "BytesPrinted", st.bytes_printed);
+  print_counter(api, "PidsInUse", st.pids_inuse);
+  api->print_string("PidsHighWater=", PRINTOUT);
+  api->print_int((int)st.pids_highwater, PRINTOUT);
+  api->print_string("</Stats>\n", PRINTOUT);
+}
+
+/** \brief Prints the live processes, a <Proc> line each.
+ * \param api API interface.
+ * */
+static void print_procs(struct loader_api_s *api){
+  struct loader_procinfo_s procs[MAXLIST];
+  int n = api->proc_snapshot(procs, MAXLIST);
+  int i;
+
+  for (i=0; i<n; i++){
+    api->print_string("<Proc>", PRINTOUT);
+    api->print_int(procs[i].pid, PRINTOUT);
+    api->print_string(",", PRINTOUT);
+    api->print_string(procs[i].fname, PRINTOUT);
+    api->print_string(",", PRINTOUT);
+    api->print_int(procs[i].state, PRINTOUT);
+    api->print_string(",", PRINTOUT);
+    api->print_int(procs[i].core_start, PRINTOUT);
+    api->print_string(",", PRINTOUT);
+    api->print_int((int)procs[i].pages, PRINTOUT);
+    api->print_string(",", PRINTOUT);
+    api->print_int((int)procs[i].bytes_requested, PRINTOUT);
+    api->print_string(",", PRINTOUT);
+    api->print_int((int)procs[i].bytes_reserved, PRINTOUT);
+    api->print_string("</Proc>\n", PRINTOUT);
+  }
+}
+
+/** \brief Starts all arguments, samples the statistics, reaps them.
+ * \param argc nr of args
+ * \param argv arguments, a list of ELF filenames
+ * \param env Environment, passed on
+ * \param api API interface, used for print,spawn,wait,stats functions
+ * \return number of children that could not be reaped
+ * */
+int lmain(int argc, char **argv, char *env, struct loader_api_s *api){
+  if (! (argc && argv && api)) return 0;
+  struct admin_s cld;
+  loader_handle_t kids[MAXKIDS];
+
+  /*clients arugments array*/
+  char *runargv[] = {""};
+  int i;
+  int n = 0;
+  int left;
+
+  print_stats(api, "Start");
+  for (i=1; (i<argc) && (n < MAXKIDS); i++){
+    ZERO_ADMINP(&cld);
+    cld.settings = e_joinable;
+    cld.core_start = 64 + (n%64);
+    cld.core_size = 1;
+    cld.argv = runargv;
+    cld.argc = 0;
+    cld.fname = argv[i];
+    cld.envp = env;
+    kids[n] = api->load_fromparam(&cld, 0);
+    if (kids[n]) n++;
+  }
+  print_stats(api, "Running");
+  print_procs(api);
+
+  /* Blocks until all are reaped */
+  left = n - api->wait_many(kids, n, 0, 0);
+  print_stats(api, "Reaped");
+  return left;
+}
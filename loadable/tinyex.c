@@ -37,7 +37,7 @@ const char * a = "123456";
  * \return zero
  * */
 int lmain(int argc, char **argv, char *env, struct loader_api_s *api){
-  int (*s)(const char*,enum e_settings, int,char**,char*);
+  loader_handle_t (*s)(const char*,enum e_settings, int,char**,char*);
   void (*output_string)(const char *, int) = api->print_string;
   void (*output_int)(int, int) = api->print_int;
   void (*output_pointer)(void*, int) = api->print_pointer;
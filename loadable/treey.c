@@ -0,0 +1,108 @@
+/**
+ * \file treey.c
+ * Spawns all arguments as a launch tree, prints per level start times.
+ *
+ **/
+#include "../loadtheone/loader_api.h"
+
+/** Maximum number of launched programs */
+#define MAXKIDS 1024
+
+/** Maximum depth of the launch tree that is recorded */
+#define MAXLEVELS 32
+
+/** Launch list, one entry per argument */
+struct admin_s kids[MAXKIDS];
+
+/** Level of the node loading each entry, -1 if none started it */
+int nodelevel[MAXKIDS];
+
+/** Start of the node loading each entry */
+clock_t nodestart[MAXKIDS];
+
+/** Earliest start per tree level, 0 if not seen */
+clock_t firststart[MAXLEVELS];
+
+/** Latest start per tree level */
+clock_t laststart[MAXLEVELS];
+
+/** \brief Notes the start of a tree node, in the slot of its entry.
+ * Nodes run concurrently, each only writes its own slot.
+ * \param entry The entry the node loads.
+ * \param level The depth of the node.
+ * \param tick When the node started.
+ * */
+void levelseen(struct admin_s *entry, int level, clock_t tick){
+  int k = entry - kids;
+  nodelevel[k] = level;
+  nodestart[k] = tick;
+}
+
+/** \brief Folds the noted node starts into per level first and last.
+ * \param n Number of entries.
+ * */
+void levelsum(int n){
+  int i, level;
+  clock_t tick;
+
+  for (i=0; i<n; i++){
+    if (nodelevel[i] < 0) continue;
+    level = nodelevel[i];
+    tick = nodestart[i];
+    if (level >= MAXLEVELS) level = MAXLEVELS - 1;
+    if ((!firststart[level]) || (tick < firststart[level])) firststart[level] = tick;
+    if (tick > laststart[level]) laststart[level] = tick;
+  }
+}
+
+/** \brief Starts all arguments as a tree, prints the level timing.
+ * \param argc nr of args
+ * \param argv arguments, a list of ELF filenames
+ * \param env Environment, passed on
+ * \param api API interface, used for print,load_tree functions
+ * \return zero
+ * */
+int lmain(int argc, char **argv, char *env, struct loader_api_s *api){
+  if (! (argc && argv && api)) return 0;
+
+  /*clients arugments array*/
+  char *runargv[] = {""};
+  int i;
+  int n = 0;
+  int failed;
+  void (*output_string)(const char *, int) = api->print_string;
+  void (*output_int)(int, int) = api->print_int;
+
+  for (i=1; (i<argc) && (n < MAXKIDS); i++){
+    ZERO_ADMINP(&kids[n]);
+    kids[n].settings = e_timeit;
+    kids[n].core_start = 64 + (n%64);
+    kids[n].core_size = 1;
+    kids[n].argv = runargv;
+    kids[n].argc = 0;
+    kids[n].fname = argv[i];
+    kids[n].envp = env;
+    nodelevel[n] = -1;
+    n++;
+  }
+
+  failed = api->load_tree(kids, n, 4, 0, &levelseen);
+  levelsum(n);
+
+  /* Level, first start, last start */
+  for (i=0; (i<MAXLEVELS) && firststart[i]; i++){
+    output_string("<Level>", PRINTOUT);
+    output_int(i, PRINTOUT);
+    output_string(",", PRINTOUT);
+    output_int(firststart[i], PRINTOUT);
+    output_string(",", PRINTOUT);
+    output_int(laststart[i], PRINTOUT);
+    output_string("</Level>\n", PRINTOUT);
+  }
+  if (failed){
+    output_string("<Failed>", PRINTOUT);
+    output_int(failed, PRINTOUT);
+    output_string("</Failed>\n", PRINTOUT);
+  }
+  return 0;
+}
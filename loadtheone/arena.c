@@ -0,0 +1,108 @@
+/**
+ * \file arena.c
+ * \brief File housing the scratch arenas.
+ *  Leendert van Duijn
+ *  UvA
+ *
+ *  Bump allocation from chunks, a load frees everything at once. Each
+ *  cache slot belongs to a single loader worker, so the caches need no
+ *  locking. Chunks are sized after the largest load seen, after a few loads
+ *  a single chunk serves everything.
+ *
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+/** Chunk kept per slot between loads */
+static struct arena_chunk_s *arenacache[ARENA_CACHES + 1];
+
+/** Most bytes a single load used per slot */
+static size_t arenapeak[ARENA_CACHES + 1];
+
+/** \brief Adds a chunk.
+ * \param a The arena.
+ * \param bytes Minimum data size.
+ * \return The chunk, NULL if malloc failed.
+ **/
+static struct arena_chunk_s *arena_grow(struct arena_s *a, size_t bytes){
+  size_t size = ARENA_CHUNK;
+  struct arena_chunk_s *c;
+
+  if (a->head && (size < a->head->size * 2)) size = a->head->size * 2;
+  if (size < bytes) size = bytes;
+  c = malloc(sizeof(struct arena_chunk_s) + size);
+  if (!c) return NULL;
+  c->next = a->head;
+  c->size = size;
+  c->used = 0;
+  a->head = c;
+  return c;
+}
+
+void arena_open(struct arena_s *a, int slot){
+  if ((slot < 0) || (slot > ARENA_CACHES)) slot = 0;
+  a->slot = slot;
+  a->used = 0;
+  a->head = NULL;
+  if (slot){
+    a->head = arenacache[slot];
+    arenacache[slot] = NULL;
+  }
+  if (!a->head && slot && arenapeak[slot]){
+    /* Sized for the largest load seen, one chunk should do */
+    arena_grow(a, arenapeak[slot]);
+  }
+  if (a->head) a->head->used = 0;
+}
+
+void *arena_alloc(struct arena_s *a, size_t bytes){
+  struct arena_chunk_s *c = a->head;
+  void *res;
+
+  /* Aligned for any type the loader stores */
+  bytes = (bytes + 15) & ~(size_t)15;
+  if (!c || (c->used + bytes > c->size)){
+    c = arena_grow(a, bytes);
+    if (!c) return NULL;
+  }
+  res = (char*)(c + 1) + c->used;
+  c->used += bytes;
+  a->used += bytes;
+  return res;
+}
+
+char *arena_strdup(struct arena_s *a, const char *s){
+  size_t l = strlen(s) + 1;
+  char *res = arena_alloc(a, l);
+  if (res) memcpy(res, s, l);
+  return res;
+}
+
+void arena_close(struct arena_s *a){
+  struct arena_chunk_s *keep = NULL;
+  struct arena_chunk_s *c = a->head;
+
+  if (a->used > arenapeak[a->slot]) arenapeak[a->slot] = a->used;
+
+  while (c){
+    struct arena_chunk_s *next = c->next;
+    /* A single chunk is kept, unless a later load needs a larger one */
+    if (a->slot && !a->head->next){
+      keep = c;
+    } else {
+      free(c);
+    }
+    c = next;
+  }
+  if (a->slot) arenacache[a->slot] = keep;
+  a->head = NULL;
+  a->used = 0;
+}
+
+size_t arena_peak(int slot){
+  if ((slot < 0) || (slot > ARENA_CACHES)) return 0;
+  return arenapeak[slot];
+}
@@ -0,0 +1,81 @@
+/**
+ * \file arena.h
+ * \author Leendert van Duijn, UvA
+ *
+ * \brief Scratch memory for a single load, released in one step.
+ *
+ * Loader workers keep their arena memory between loads, so a steady stream
+ * of loads does not go to malloc at all.
+ **/
+
+#ifndef H_ARENA
+#define H_ARENA
+
+#include <stddef.h>
+
+#ifndef ARENA_CACHES
+/** Number of cached arenas, slots above this are not cached */
+#define ARENA_CACHES 8
+#endif /* ARENA_CACHES */
+
+#ifndef ARENA_CHUNK
+/** Smallest chunk taken from malloc */
+#define ARENA_CHUNK ((size_t)1 << 16)
+#endif /* ARENA_CHUNK */
+
+/** A piece of arena memory, data follows the header */
+struct arena_chunk_s {
+  /** Older chunk */
+  struct arena_chunk_s *next;
+  /** Bytes of data */
+  size_t size;
+  /** Bytes handed out */
+  size_t used;
+};
+
+/** An arena, lives on the stack of a load */
+struct arena_s {
+  /** Newest chunk, allocations come from here */
+  struct arena_chunk_s *head;
+  /** Cache slot, 0 for none */
+  int slot;
+  /** Bytes handed out */
+  size_t used;
+};
+
+/**
+ * Starts an arena.
+ * \param a The arena.
+ * \param slot Cache to take memory from, only one user per slot at a time,
+ * 0 for no cache.
+ **/
+void arena_open(struct arena_s *a, int slot);
+
+/**
+ * Allocates from an arena, aligned for any type.
+ * \param a The arena.
+ * \param bytes Requested size.
+ * \return The memory, NULL if malloc failed.
+ **/
+void *arena_alloc(struct arena_s *a, size_t bytes);
+
+/**
+ * \param a The arena.
+ * \param s String to copy.
+ * \return Copy of s, NULL if malloc failed.
+ **/
+char *arena_strdup(struct arena_s *a, const char *s);
+
+/**
+ * Releases everything allocated, the largest chunk is kept for the slot.
+ * \param a The arena.
+ **/
+void arena_close(struct arena_s *a);
+
+/**
+ * \param slot The cache slot, 0 for loads without one (approximate).
+ * \return Most bytes a single load on slot used.
+ **/
+size_t arena_peak(int slot);
+
+#endif /* H_ARENA */
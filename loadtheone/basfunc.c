@@ -24,6 +24,13 @@
 #include <stdint.h>
 #include "basfunc.h"
 #include "loader.h"
+#include "heap.h"
+#include "lockstat.h"
+#include "stats.h"
+
+#if ENABLE_PERFCOUNTERS
+#include <svp/perf.h>
+#endif /* ENABLE_PERFCOUNTERS */
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -65,12 +72,81 @@ size_t bytes_from_bits(size_t bits){
 #define maxpagebits ((size_t)  19)
 #endif /*maxpagebits*/
 
+/** Families of e_joinable processes, synced on by function_join */
+static sl_family_t joinfamily[MAXPROCS];
+
+/** Loader API per process, carries the pid for the heap calls */
+static struct loader_api_s procapi[MAXPROCS];
+
 /** Minimum number of bytes in a page */
 static const size_t minpagebytes = (size_t)1 << minpagebits; 
 
 /** Maximum number of bytes in a page */
 static const size_t maxpagebytes = (size_t)1 << maxpagebits; 
 
+#ifndef PAGEREC_MAX
+/** Pages remembered per pid, a pid mapping more is not recycled */
+#define PAGEREC_MAX 64
+#endif /*PAGEREC_MAX*/
+
+#ifndef RECYCLE_CAP
+/** Bytes of dead processes kept mapped before exiting pids are trimmed */
+#define RECYCLE_CAP ((size_t)32 << 20)
+#endif /*RECYCLE_CAP*/
+
+/**
+ * Pages mapped on behalf of a pid.
+ * Pages survive the death of the pid and are handed to the next process
+ * using the same pid, which maps the same addresses when running the same
+ * image.
+ */
+struct pagerec_s {
+  /** Start of each page */
+  void *addr[PAGEREC_MAX];
+  /** Address width of each page */
+  unsigned char bits[PAGEREC_MAX];
+  /** Set when the page is in use by the current owner */
+  unsigned char live[PAGEREC_MAX];
+  /** Set when a kept page has been cleared since its last owner */
+  unsigned char zero[PAGEREC_MAX];
+  /** Number of recorded pages */
+  int count;
+  /** Set when pages were mapped without being recorded */
+  int overflow;
+  /** Bytes counted in recycled_bytes for this pid */
+  size_t keptbytes;
+  /** Bytes mapped for this pid, recorded or not, only changed on MEMCORE */
+  size_t mappedbytes;
+};
+
+/** Page records, only touched by the owner of the pid or on MEMCORE */
+static struct pagerec_s pagerecs[MAXPROCS];
+
+/** Bytes kept mapped for dead pids, only changed on MEMCORE */
+static size_t recycled_bytes = 0;
+
+/**
+ * \brief Counts a page newly mapped, on MEMCORE only.
+ * \param rec The page records of the owning pid.
+ * \param bytes The page size.
+ */
+static void mapped_add(struct pagerec_s *rec, size_t bytes){
+  rec->mappedbytes += bytes;
+  stats_places.bytes_mapped += bytes;
+  if (stats_places.bytes_mapped > stats_places.bytes_mapped_highwater){
+    stats_places.bytes_mapped_highwater = stats_places.bytes_mapped;
+  }
+}
+
+/**
+ * \brief Counts all pages of a pid as unmapped, on MEMCORE only.
+ * \param rec The page records of the pid.
+ */
+static void mapped_drop(struct pagerec_s *rec){
+  stats_places.bytes_mapped -= rec->mappedbytes;
+  rec->mappedbytes = 0;
+}
+
 /* \brief Do action param on a single page.
  * Reserve a single page.
  * Returns an indication of success.
@@ -79,7 +155,8 @@ static const size_t maxpagebytes = (size_t)1 << maxpagebits;
  * \param pid Which action to do MGSCTL_MEM_MAP for example.
  * \return 0 on success, -1 on invalid parameters
  * */
-sl_def(lockme_reserve_single,, sl_glparm(void*, addr),sl_glparm(size_t, sz_bits), sl_glparm(long, pid) ){
+sl_def(lockme_reserve_single,, sl_glparm(void*, addr),sl_glparm(size_t, sz_bits), sl_glparm(long, pid),
+    sl_glparm(clock_t, t0)){
   /**
    * A worthwhile investment might be COW zero filled pages, allowing fast
    * allocation of meory voiding the need to manually fill it with nullbytes,
@@ -89,25 +166,199 @@ sl_def(lockme_reserve_single,, sl_glparm(void*, addr),sl_glparm(size_t, sz_bits)
   void *addr = sl_getp(addr);
   size_t sz_bits = sl_getp(sz_bits);
   long pid = sl_getp(pid);
+  LOCK_ENTER(lock_mem, sl_getp(t0));
   DOPID(pid);
   MAPONPID(addr, sz_bits-minpagebits);
+  stats_places.pages_mapped++;
+  mapped_add(&pagerecs[pid], (size_t)1 << sz_bits);
+  LOCK_LEAVE(lock_mem);
+}
+sl_enddef
+
+/**
+ * \brief Drop the recycled pages of a pid, keep its live pages.
+ * Unmaps everything and maps the live pages again, so every live page must
+ * be recorded, never call for an overflowed pid.
+ * \param pid The owning pid.
+ */
+sl_def(lockme_recycle_flush,, sl_glparm(long, pid), sl_glparm(clock_t, t0)){
+  long pid = sl_getp(pid);
+  struct pagerec_s *rec = &pagerecs[pid];
+  int i, n = 0;
+  LOCK_ENTER(lock_mem, sl_getp(t0));
+
+  UNMAPONPID(pid);
+  stats_places.pages_unmapped += rec->count;
+  mapped_drop(rec);
+  recycled_bytes -= rec->keptbytes;
+  rec->keptbytes = 0;
+  for (i=0;i<rec->count;i++){
+    if (!rec->live[i]) continue;
+    DOPID(pid);
+    MAPONPID(rec->addr[i], rec->bits[i]-minpagebits);
+    stats_places.pages_mapped++;
+    mapped_add(rec, (size_t)1 << rec->bits[i]);
+    rec->addr[n] = rec->addr[i];
+    rec->bits[n] = rec->bits[i];
+    rec->live[n] = 1;
+    rec->zero[n] = 0;
+    n++;
+  }
+  rec->count = n;
+  LOCK_LEAVE(lock_mem);
 }
 sl_enddef
 
+/**
+ * \brief Decide whether the pages of a dead pid are kept.
+ * Pages are kept while the total stays within RECYCLE_CAP, otherwise the
+ * pid is trimmed to nothing.
+ * \param pid The dead pid.
+ */
+sl_def(lockme_recycle_exit,, sl_glparm(long, pid), sl_glparm(clock_t, t0)){
+  long pid = sl_getp(pid);
+  struct pagerec_s *rec = &pagerecs[pid];
+  size_t bytes = 0;
+  int i;
+  LOCK_ENTER(lock_mem, sl_getp(t0));
+
+  recycled_bytes -= rec->keptbytes;
+  rec->keptbytes = 0;
+  for (i=0;i<rec->count;i++){
+    bytes += (size_t)1 << rec->bits[i];
+  }
+
+  if (rec->overflow || (recycled_bytes + bytes > RECYCLE_CAP)){
+    UNMAPONPID(pid);
+    stats_places.pages_unmapped += rec->count;
+    mapped_drop(rec);
+    rec->count = 0;
+    rec->overflow = 0;
+  } else {
+    for (i=0;i<rec->count;i++){
+      rec->live[i] = 0;
+      rec->zero[i] = 0;
+    }
+    rec->keptbytes = bytes;
+    recycled_bytes += bytes;
+  }
+  LOCK_LEAVE(lock_mem);
+}
+sl_enddef
+
+/**
+ * \brief Look for a page kept from an earlier owner of pid.
+ * \param addr Starting address of the page.
+ * \param sz_bits The desired pade width.
+ * \param pid The owning PID.
+ * \param zero Set to 1 if the page was cleared after its last owner.
+ * \return 1 when the page is still mapped, 0 when it needs mapping, -1 when
+ * a kept page is in the way.
+ */
+static int recycle_find(void *addr, size_t sz_bits, long pid, int *zero){
+  struct pagerec_s *rec = &pagerecs[pid];
+  char *start = addr;
+  char *end = start + ((size_t)1 << sz_bits);
+  int i;
+
+  for (i=0;i<rec->count;i++){
+    char *rstart = rec->addr[i];
+    char *rend = rstart + ((size_t)1 << rec->bits[i]);
+
+    if (rec->live[i] || (end <= rstart) || (start >= rend)) continue;
+    if ((rstart == start) && (rec->bits[i] == sz_bits)){
+      rec->live[i] = 1;
+      *zero = rec->zero[i];
+      return 1;
+    }
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * \brief Accounts a page handed to pid, by its owner only.
+ * \param pid The owning PID, 0 for blocks of the loader itself.
+ * \param sz_bits The page width.
+ */
+static void reserve_account(long pid, size_t sz_bits){
+  struct admin_s *p = &proctable[pid];
+  size_t c = sz_bits - minpagebits;
+
+  if (c >= LOADER_PAGECLASSES) c = LOADER_PAGECLASSES - 1;
+  p->pageclass[c]++;
+  p->bytes_reserved += (size_t)1 << sz_bits;
+  STAT_ADD(pid, bytes_reserved, (size_t)1 << sz_bits);
+}
+
+/**
+ * \param rec The page records of a pid.
+ * \return True if pages kept from an earlier owner are recorded.
+ */
+static int recycle_kept(const struct pagerec_s *rec){
+  int i;
+  for (i=0;i<rec->count;i++){
+    if (!rec->live[i]) return 1;
+  }
+  return 0;
+}
+
 /** 
  * Allocate a single page.
+ * Pages kept from an earlier process with the same pid are reused without
+ * going to MEMCORE.
  * \param addr Starting address of the page.
  * \param sz_bits The desired pade width.
  * \param pid The owning PID.
+ * \param zero Set to 1 if the page is known to hold only nullbytes.
  * \return 0 on success
  **/
-int reserve_single(void *addr, size_t sz_bits, long pid){
+static int reserve_single(void *addr, size_t sz_bits, long pid, int *zero){
+  struct pagerec_s *rec;
 
+  *zero = 0;
   if ((sz_bits >= minpagebits ) && (sz_bits <= maxpagebits)){
+    rec = &pagerecs[pid];
+    /*
+     * A flush maps back the recorded live pages only, so it is only safe
+     * while every live page is recorded. Once overflowed nothing is reused
+     * or flushed, the pages all go at exit.
+     */
+    if (!rec->overflow && (rec->count >= PAGEREC_MAX) && recycle_kept(rec)){
+      /* Make room by dropping the kept pages, before any goes unrecorded */
+      sl_create(, MAKE_CLUSTER_ADDR(MEMCORE, 1) ,,,,, sl__exclusive, lockme_recycle_flush, sl_glarg(long, pid, pid),
+      sl_glarg(clock_t, t0, LOCK_REQUEST()));
+      sl_sync();
+    }
+    switch (rec->overflow ? 0 : recycle_find(addr, sz_bits, pid, zero)){
+      case 1:
+        reserve_account(pid, sz_bits);
+        return 0;
+      case -1:
+        sl_create(, MAKE_CLUSTER_ADDR(MEMCORE, 1) ,,,,, sl__exclusive, lockme_recycle_flush, sl_glarg(long, pid, pid),
+      sl_glarg(clock_t, t0, LOCK_REQUEST()));
+        sl_sync();
+        break;
+      default:
+        break;
+    }
+
     sl_create(, MAKE_CLUSTER_ADDR(MEMCORE, 1) ,,,,, sl__exclusive, lockme_reserve_single, sl_glarg(void*, addr,addr),
                                                                                   sl_glarg(size_t,sz_bits,sz_bits),
-                                                                                  sl_glarg(long, pid,pid) );
+                                                                                  sl_glarg(long, pid,pid),
+                                                                                  sl_glarg(clock_t, t0, LOCK_REQUEST()) );
     sl_sync();
+
+    if (rec->count < PAGEREC_MAX){
+      rec->addr[rec->count] = addr;
+      rec->bits[rec->count] = sz_bits;
+      rec->live[rec->count] = 1;
+      rec->zero[rec->count] = 0;
+      rec->count++;
+    } else {
+      rec->overflow = 1;
+    }
+    reserve_account(pid, sz_bits);
     return 0;
   }
   return -1;
@@ -115,23 +366,81 @@ int reserve_single(void *addr, size_t sz_bits, long pid){
 
 /**
  * Cancel All owned (by pid) memory.
+ * The pages stay mapped for the next owner of pid unless the recycle cap is
+ * reached.
  * \param pid Which owning processes memory.
  * \return 0 on success.
  * */
 int reserve_cancel_pid(long pid){
+  sl_create(, MAKE_CLUSTER_ADDR(MEMCORE, 1) ,,,,, sl__exclusive, lockme_recycle_exit, sl_glarg(long, pid, pid),
+      sl_glarg(clock_t, t0, LOCK_REQUEST()));
+  sl_sync();
+  return 0;
+}
+
+/**
+ * \brief Drops everything a pid has mapped, kept or not.
+ * \param pid The pid.
+ */
+sl_def(lockme_recycle_trim,, sl_glparm(long, pid), sl_glparm(clock_t, t0)){
+  long pid = sl_getp(pid);
+  struct pagerec_s *rec = &pagerecs[pid];
+  LOCK_ENTER(lock_mem, sl_getp(t0));
+
   UNMAPONPID(pid);
+  stats_places.pages_unmapped += rec->count;
+  mapped_drop(rec);
+  recycled_bytes -= rec->keptbytes;
+  rec->keptbytes = 0;
+  rec->count = 0;
+  rec->overflow = 0;
+  LOCK_LEAVE(lock_mem);
+}
+sl_enddef
+
+int reserve_trim_pid(long pid){
+  sl_create(, MAKE_CLUSTER_ADDR(MEMCORE, 1) ,,,,, sl__exclusive, lockme_recycle_trim, sl_glarg(long, pid, pid),
+      sl_glarg(clock_t, t0, LOCK_REQUEST()));
+  sl_sync();
   return 0;
 }
 
+int reserve_kept(long pid){
+  return pagerecs[pid].count > 0;
+}
+
+/**
+ * Clears the pages kept for pid.
+ * Meant to run off the load path, before the pid is handed out again.
+ * \param pid The dead pid, not yet released.
+ * \return Number of bytes cleared.
+ * */
+size_t reserve_zero_pid(long pid){
+  struct pagerec_s *rec = &pagerecs[pid];
+  size_t bytes = 0;
+  int i;
+
+  for (i=0;i<rec->count;i++){
+    if (rec->live[i] || rec->zero[i]) continue;
+    memset(rec->addr[i], 0, (size_t)1 << rec->bits[i]);
+    rec->zero[i] = 1;
+    bytes += (size_t)1 << rec->bits[i];
+  }
+  STAT_ADD(pid, bytes_zeroed, bytes);
+  return bytes;
+}
+
 /** \brief Do action param on a range of memory.
  * \param addr the starting address.
  * \param bytes the requested size.
  * \param perm the requested permissions.
  * \param pid what pid it belongs to.
+ * \param zero If set, receives 1 if every page is known to hold nullbytes.
  * \return pointer to the end of the actual range.
  * The return value may be higher than addr+size due to page size limitations.
  */
-void* reserve_range(void *addr, size_t bytes, enum e_perms perm, long pid){
+void* reserve_range_z(void *addr, size_t bytes, enum e_perms perm, long pid,
+                      int *zero){
   /**
    * Reserve a range of bytes, try to obtain at least perm permissions.
    * Returns a pointer to the actual end of the range.
@@ -141,11 +450,16 @@ void* reserve_range(void *addr, size_t bytes, enum e_perms perm, long pid){
   
   size_t sz_bits = 1;
   size_t i;
-  size_t bbytes = bytes >> 1;
+  size_t bbytes = (bytes - 1) >> 1;
   size_t resc = 0;
+  int z;
+  int allzero = 1;
   
   //No permissions available for now
   (void) perm;
+  if (zero) *zero = 0;
+  proctable[pid].bytes_requested += bytes;
+  STAT_ADD(pid, bytes_requested, bytes);
 
   while (bbytes > 0){
     bbytes = bbytes >> 1;
@@ -154,12 +468,14 @@ void* reserve_range(void *addr, size_t bytes, enum e_perms perm, long pid){
 
   if ((bytes >= minpagebytes ) && (bytes <= maxpagebytes)){
     //If a single page is ok, use it.
-    if (reserve_single(addr, sz_bits, pid)) return 0;
+    if (reserve_single(addr, sz_bits, pid, &z)) return 0;
+    if (zero) *zero = z;
     return addr + (1 << sz_bits);
   }
   pages = bytes / maxpagebytes;
   for (i=0;i<pages;i++){
-    if (reserve_single(addr, maxpagebits, pid)) return addr + resc;
+    if (reserve_single(addr, maxpagebits, pid, &z)) return addr + resc;
+    allzero = allzero && z;
 
     addr += maxpagebytes;
     resc += maxpagebytes;
@@ -168,15 +484,17 @@ void* reserve_range(void *addr, size_t bytes, enum e_perms perm, long pid){
   i = bytes % maxpagebytes;
   if (i) { 
     sz_bits = 1;
-    i = i >> 1;
+    i = (i - 1) >> 1;
     while (i > 0){
       i = i >> 1;
       sz_bits++;
     }
     if (sz_bits < minpagebits) sz_bits = minpagebits;
-    if (reserve_single(addr, sz_bits, pid)) return 0;
+    if (reserve_single(addr, sz_bits, pid, &z)) return 0;
+    allzero = allzero && z;
     resc += 1 << sz_bits;
   }
+  if (zero) *zero = allzero;
 
   /**
    * What protection is wanted is told in perms, however, setting these...
@@ -186,6 +504,46 @@ void* reserve_range(void *addr, size_t bytes, enum e_perms perm, long pid){
   return addr + resc;
 }
 
+void* reserve_range(void *addr, size_t bytes, enum e_perms perm, long pid){
+  return reserve_range_z(addr, bytes, perm, pid, NULL);
+}
+
+size_t reserve_span(size_t bytes){
+  size_t span = (bytes / maxpagebytes) * maxpagebytes;
+  size_t rest = bytes % maxpagebytes;
+  size_t page = minpagebytes;
+
+  if (!rest) return span;
+  while (page < rest) page <<= 1;
+  return span + page;
+}
+
+#if ENABLE_PERFCOUNTERS
+/** MTPERF counter behind each e_perf */
+static const int perfsources[pf_count] = {
+  MTPERF_CLOCKS,
+  MTPERF_EXECUTED_INSNS,
+  MTPERF_COMPLETED_LOADS,
+  MTPERF_COMPLETED_STORES,
+  MTPERF_LINES_LOADED
+};
+
+/**
+ * \brief Adds the counter change since before to a process.
+ * \param before Sample from before the main function.
+ * \param params The process.
+ */
+static void perf_delta(const counter_t *before, struct admin_s *params){
+  counter_t after[MTPERF_NCOUNTERS];
+  int i;
+
+  mtperf_sample(after);
+  for (i=0;i<pf_count;i++){
+    params->perfdelta[i] = after[perfsources[i]] - before[perfsources[i]];
+  }
+}
+#endif /* ENABLE_PERFCOUNTERS */
+
 /* \brief This is the skeleton which boots a new program.
  *  \param f the called main function.
  *  \param params the administration block used for settings and such.
@@ -201,13 +559,30 @@ sl_def(thread_function,,
   int ac = params->argc;
   char **av = params->argv;
   char *e = params->envp;
-  struct loader_api_s *p = &loader_api;
+  struct loader_api_s *p = &procapi[params->pidnum];
+#if ENABLE_PERFCOUNTERS
+  counter_t before[MTPERF_NCOUNTERS];
+#endif /* ENABLE_PERFCOUNTERS */
+
+  *p = loader_api;
+  p->pid = params->pidnum;
+  heap_reset(params->pidnum);
+
+#if ENABLE_PERFCOUNTERS
+  /* Counters are per core, the first core of the place stands for it */
+  mtperf_sample(before);
+#endif /* ENABLE_PERFCOUNTERS */
   
   int exit_code = (*f)(ac, av, e, p);
 
+#if ENABLE_PERFCOUNTERS
+  perf_delta(before, params);
+#endif /* ENABLE_PERFCOUNTERS */
+
 #if ENABLE_CLOCKCALLS
   params->lasttick = clock();
 #endif /* ENABLE_CLOCKCALLS */
+  params->exit_code = exit_code;
   
   if (exit_code != 0){
     /** \brief Could print some feedback about termination */
@@ -274,11 +649,29 @@ int function_spawn(main_function_t * main_f,
   int cad = MAKE_CLUSTER_ADDR(params->core_start,params->core_size);
   cad = (params->core_start == -1)?0:cad;
 
+  PROC_WRITE_BEGIN(params);
 #if ENABLE_CLOCKCALLS
   params->detachtick = clock();
 #endif /* ENABLE_CLOCKCALLS */
-
-  if (params->settings & e_exclusive){ 
+  params->state = proc_running;
+  PROC_WRITE_END(params);
+
+  if (params->settings & e_joinable){
+    /* Kept, the family is the object a waiter syncs on */
+    sl_spawndecl(f);
+    if (params->settings & e_exclusive){
+      sl_spawn(f, cad, , , , , sl__exclusive, thread_function,
+        sl_glarg(main_function_t* ,, main_f),
+        sl_glarg(struct admin_s*, , params)
+      );
+    } else {
+      sl_spawn(f, cad, , , , , , thread_function,
+        sl_glarg(main_function_t* ,, main_f),
+        sl_glarg(struct admin_s*, , params)
+      );
+    }
+    joinfamily[params->pidnum] = f;
+  } else if (params->settings & e_exclusive){ 
     sl_create( ,cad, , , , , sl__exlusive, thread_function, 
       sl_glarg(main_function_t* ,, main_f),
       sl_glarg(struct admin_s*, , params)
@@ -295,6 +688,119 @@ int function_spawn(main_function_t * main_f,
   return 0;
 }
 
+/**
+ * \brief Waits for the family of an e_joinable process to terminate.
+ * \param pid The process, spawned by function_spawn with e_joinable.
+ * \return 0 on success.
+ */
+int function_join(int pid){
+  sl_spawndecl(f);
+  f = joinfamily[pid];
+  sl_spawnsync(f);
+  return 0;
+}
+
+/**
+ * \brief Prepares an empty completion queue.
+ * \param cq The queue.
+ */
+void cq_init(struct loader_cq_s *cq){
+  cq->head = 0;
+  cq->tail = 0;
+  cq->dropped = 0;
+  cq->reported = 0;
+}
+
+/**
+ * \brief Pushes the record of a terminated process.
+ * Producers must be serialized, call from an exclusive family only.
+ * The owner reads without locking, the record is written before head moves.
+ * \param cq The queue.
+ * \param p The terminated process.
+ */
+void cq_push(struct loader_cq_s *cq, struct admin_s *p){
+  unsigned long head = cq->head;
+  struct loader_completion_s *rec;
+
+  if (head - cq->tail >= CQ_SIZE){
+    /* Full, the owner has more children out than it can be told about */
+    cq->dropped++;
+    return;
+  }
+  rec = &cq->ring[head % CQ_SIZE];
+  rec->pidnum = p->pidnum;
+  rec->generation = p->generation;
+  rec->exit_code = p->exit_code;
+  rec->createtick = p->createtick;
+  rec->detachtick = p->detachtick;
+  rec->lasttick = p->lasttick;
+  rec->cleaneduptick = p->cleaneduptick;
+  cq->head = head + 1;
+}
+
+#ifndef CQ_WAIT_ROUNDS
+/** Looks at an empty queue a waiting cq_drain takes before giving up */
+#define CQ_WAIT_ROUNDS 1024
+#endif /*CQ_WAIT_ROUNDS*/
+
+#ifndef CQ_BACKOFF_MAX
+/** Most threads in the family a waiting cq_drain yields to */
+#define CQ_BACKOFF_MAX 64
+#endif /*CQ_BACKOFF_MAX*/
+
+/* Does nothing, a family of these keeps a drainer off the queue for a while */
+sl_def(slcq_yield_fn,, sl_glparm(int, round)){
+  (void)sl_getp(round);
+}
+sl_enddef
+
+/**
+ * \brief Takes records of terminated processes, in order of termination.
+ * Only the owner of the queue may drain it.
+ * There is no way for a pusher to wake a drainer, so a waiting drainer backs
+ * off: between looks at head it creates and syncs a family of empty threads,
+ * doubling up to CQ_BACKOFF_MAX, leaving the queue and its core to others.
+ * After CQ_WAIT_ROUNDS looks it returns empty handed, callers retry.
+ * Records lost to a full queue are reported once, ahead of records still
+ * queued, so a caller counting its children can catch up.
+ * \param cq The queue.
+ * \param out Receives the records.
+ * \param max Room in out.
+ * \param flags e_wait_nohang to return 0 on an empty queue instead of waiting
+ * for the first record.
+ * \return Number of records taken, 0 if the wait ran out, minus the number of
+ * lost records when any were lost since the last call.
+ */
+int cq_drain(struct loader_cq_s *cq, struct loader_completion_s *out,
+             int max, enum e_waitflags flags){
+  int n = 0;
+  unsigned long tail = cq->tail;
+  int backoff = 1;
+  int round;
+
+  if (max <= 0) return 0;
+  if (!(flags & e_wait_nohang)){
+    /* Producers only ever move head and dropped forward */
+    for (round=0;(cq->head == tail) && (cq->dropped == cq->reported) &&
+        (round < CQ_WAIT_ROUNDS);round++){
+      sl_create(,, 0, backoff, 1,,, slcq_yield_fn, sl_glarg(int, round, round));
+      sl_sync();
+      if (backoff < CQ_BACKOFF_MAX) backoff <<= 1;
+    }
+  }
+  if (cq->dropped != cq->reported){
+    unsigned long lost = cq->dropped - cq->reported;
+    cq->reported += lost;
+    return -(int)lost;
+  }
+  while ((n < max) && (tail != cq->head)){
+    out[n] = cq->ring[tail % CQ_SIZE];
+    tail++;
+    n++;
+  }
+  cq->tail = tail;
+  return n;
+}
 
 /**
  * \brief spawn a program based on filename and arguments.
@@ -302,9 +808,9 @@ int function_spawn(main_function_t * main_f,
  * \param argc passed argc
  * \param argv an string pointer array, strings get copied.
  * \param env double null terminated string table, gets copied.
- * \return 0 on success.
+ * \return Handle of the started process, 0 on failure.
  */
-int loader_spawn(const char *programma, int argc, char **argv, char *env) {
+loader_handle_t loader_spawn(const char *programma, int argc, char **argv, char *env) {
   return elf_loadfile(programma, 0, argc ,argv, env);
 }
 
@@ -314,10 +820,14 @@ int loader_spawn(const char *programma, int argc, char **argv, char *env) {
  * \param fd the output stream PRINTERR or PRINTOUT
  * \return nothing
  */
-sl_def(slprintstr_fn,, sl_glparm(const char*, strp), sl_glparm(int, fd)){
+sl_def(slprintstr_fn,, sl_glparm(const char*, strp), sl_glparm(int, fd), sl_glparm(clock_t, t0)){
   const char *val = sl_getp(strp);
   int fdd = sl_getp(fd);
+  LOCK_ENTER(lock_print, sl_getp(t0));
   output_string(val, fdd);
+  stats_places.prints++;
+  stats_places.bytes_printed += strlen(val);
+  LOCK_LEAVE(lock_print);
 }
 sl_enddef
 
@@ -328,7 +838,8 @@ sl_enddef
  * \return nothing
  */
 void locked_print_string(const char *stin, int fp){
-  sl_create(, MAKE_CLUSTER_ADDR(PRINTCORE, 1) ,,,,, sl__exclusive, slprintstr_fn, sl_glarg(const char *, strp, stin), sl_glarg(int , fd, fp) );
+  sl_create(, MAKE_CLUSTER_ADDR(PRINTCORE, 1) ,,,,, sl__exclusive, slprintstr_fn, sl_glarg(const char *, strp, stin), sl_glarg(int , fd, fp),
+      sl_glarg(clock_t, t0, LOCK_REQUEST()) );
   sl_sync();
 }
 
@@ -342,7 +853,8 @@ void locked_print_pointer(void* pl, int fp){
   char buff[128];
   buff[0] = 0;
   snprintf(buff,127, "%016lx", (unsigned long) pl);
-  sl_create(, MAKE_CLUSTER_ADDR(PRINTCORE, 1) ,,,,, sl__exclusive, slprintstr_fn, sl_glarg(const char *, strp, buff), sl_glarg(int , fd, fp) );
+  sl_create(, MAKE_CLUSTER_ADDR(PRINTCORE, 1) ,,,,, sl__exclusive, slprintstr_fn, sl_glarg(const char *, strp, buff), sl_glarg(int , fd, fp),
+      sl_glarg(clock_t, t0, LOCK_REQUEST()) );
   sl_sync();
 }
 
@@ -353,10 +865,13 @@ void locked_print_pointer(void* pl, int fp){
  * \param fd the output stream PRINTERR or PRINTOUT
  * \return nothing
  */
-sl_def(slprintint_fn,, sl_glparm(int, pl), sl_glparm(int, fd)){
+sl_def(slprintint_fn,, sl_glparm(int, pl), sl_glparm(int, fd), sl_glparm(clock_t, t0)){
   int val = sl_getp(pl);
   int fdd = sl_getp(fd);
+  LOCK_ENTER(lock_print, sl_getp(t0));
   output_int(val, fdd);
+  stats_places.prints++;
+  LOCK_LEAVE(lock_print);
 }
 sl_enddef
 
@@ -367,7 +882,8 @@ sl_enddef
  * \return nothing
  */
 void locked_print_int(int val, int fp){
-  sl_create(, MAKE_CLUSTER_ADDR(PRINTCORE, 1) ,,,,, sl__exclusive, slprintint_fn, sl_glarg(int, pl, val), sl_glarg(int , fd, fp) );
+  sl_create(, MAKE_CLUSTER_ADDR(PRINTCORE, 1) ,,,,, sl__exclusive, slprintint_fn, sl_glarg(int, pl, val), sl_glarg(int , fd, fp),
+      sl_glarg(clock_t, t0, LOCK_REQUEST()) );
   sl_sync();
 }
 
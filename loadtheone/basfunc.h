@@ -39,8 +39,42 @@ enum e_perms {
  * \brief Allocates a range of memory, owned by pid, permissions set to perm.
  * */
 void* reserve_range(void *addr, size_t bytes, enum e_perms perm, long pid);
+
+/**
+ * As reserve_range, also reports whether the range is known to be cleared.
+ * \param zero If set, receives 1 if every page holds only nullbytes.
+ * */
+void* reserve_range_z(void *addr, size_t bytes, enum e_perms perm, long pid,
+                      int *zero);
 int reserve_cancel_pid(long pid);
 
+/**
+ * Bytes reserve_range maps for a request, pages are powers of two.
+ * \param bytes Requested size.
+ * \return Mapped size.
+ * */
+size_t reserve_span(size_t bytes);
+
+/**
+ * Unmaps everything of pid, including pages kept for recycling.
+ * \param pid The pid, not running.
+ * \return 0 on success.
+ * */
+int reserve_trim_pid(long pid);
+
+/**
+ * \param pid A dead pid.
+ * \return True if pages of pid are kept mapped, its addresses are in use.
+ * */
+int reserve_kept(long pid);
+
+/**
+ * Clears the pages kept for a dead pid, before it is released.
+ * \param pid The dead pid.
+ * \return Number of bytes cleared.
+ * */
+size_t reserve_zero_pid(long pid);
+
 /**
  * \param a First string.
  * \param b Second string.
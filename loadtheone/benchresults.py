@@ -0,0 +1,112 @@
+#!/usr/bin/env python
+import sys
+import os
+import json
+
+#
+# Leendert van Duijn
+#
+# Script for turning the logs of 'make bench' into one results file, usage:
+#   ./benchresults.py ./logs/bench/*.log > ./logs/bench/results.json
+# Logs are named workload_profile.log. Exits non zero when a run finished
+# fewer loads than its workload starts.
+#
+
+#Timed loads each workload starts, as in its cfg
+workloads = {
+  "benchnull":128,
+  "benchsec":128,
+  "benchbig":16,
+  "benchreloc":32,
+  "benchprint":16,
+  "benchchurn":128
+}
+
+#Rates are per million ticks, clock() counts core cycles of the simulated
+#machine and its frequency depends on the profile
+mcycle = 1000000
+
+#Fields of a Clocks record, as leg in runlogs.py
+f_create = 3
+f_detach = 4
+f_end = 5
+f_cleaned = 6
+
+def between(strd, tag):
+  """ The text between <tag...> and </tag>, None if absent """
+  start = strd.find("<" + tag)
+  if start < 0:
+    return None
+  start = strd.index(">", start) + 1
+  end = strd.find("</" + tag + ">", start)
+  if end < 0:
+    return None
+  return strd[start:end]
+
+def quantile(vals, permille):
+  """ Nearest rank quantile of a sorted list """
+  if not vals:
+    return 0
+  rank = (len(vals) * permille + 999) // 1000
+  return vals[max(rank, 1) - 1]
+
+def latency(vals):
+  """ Count, percentiles and max of a list of tick counts """
+  vals = sorted(vals)
+  return {"count":len(vals), "p50":quantile(vals, 500),
+          "p90":quantile(vals, 900), "p99":quantile(vals, 990),
+          "max":vals[-1] if vals else 0}
+
+def run(fname):
+  """ Summarizes a single log """
+  name = os.path.basename(fname)[:-len(".log")]
+  workload, profile = name.rsplit("_", 1)
+  clocks = list()
+  hists = dict()
+  locks = dict()
+  for line in open(fname, "r"):
+    rec = between(line, "Clocks")
+    if rec is not None:
+      clocks.append([int(float(x)) for x in rec.split(",")])
+      continue
+    rec = between(line, "Hist")
+    if rec is not None:
+      #Later summaries include the earlier ones
+      f = rec.split(",")
+      hists[f[0]] = {"count":int(f[1]), "p50":int(f[2]), "p90":int(f[3]),
+                     "p99":int(f[4]), "max":int(f[5])}
+      continue
+    rec = between(line, "Lock")
+    if rec is not None:
+      f = rec.split(",")
+      locks[f[0]] = {"requests":int(f[1]), "wait":int(f[2]),
+                     "hold":int(f[3]), "maxwait":int(f[4])}
+
+  res = {"workload":workload, "profile":profile, "loads":len(clocks),
+         "expected":workloads.get(workload, 0)}
+  if clocks:
+    first = min(c[f_create] for c in clocks)
+    last = max(c[f_create] + c[f_cleaned] for c in clocks)
+    span = max(last - first, 1)
+    res["span_ticks"] = span
+    res["loads_per_mcycle"] = len(clocks) * float(mcycle) / span
+    res["to_detach"] = latency([c[f_detach] for c in clocks])
+    res["to_end"] = latency([c[f_end] for c in clocks])
+    res["to_cleaned"] = latency([c[f_cleaned] for c in clocks])
+  res["hist"] = hists
+  res["locks"] = locks
+  res["pass"] = (len(clocks) > 0) and (len(clocks) >= res["expected"])
+  return res
+
+if __name__ == "__main__":
+  if len(sys.argv) < 2:
+    sys.stderr.write("usage: benchresults.py log [log...]\n")
+    sys.exit(1)
+  runs = [run(fname) for fname in sorted(sys.argv[1:])]
+  for r in runs:
+    if not r["pass"]:
+      sys.stderr.write("%s_%s: %d of %d loads\n" %
+          (r["workload"], r["profile"], r["loads"], r["expected"]))
+  ok = all(r["pass"] for r in runs)
+  print(json.dumps({"pass":ok, "runs":runs}, indent=1))
+  sys.exit(0 if ok else 1)
@@ -24,12 +24,64 @@
 #include "ELF.h"
 #include "basfunc.h"
 #include "loader.h"
+#include "sched.h"
+#include "pool.h"
+#include "intern.h"
+#include "arena.h"
+#include "region.h"
+#include "heap.h"
+#include "trace.h"
+#include "hist.h"
+#include "lockstat.h"
+#include "stats.h"
 
 /** Which node is used for PID/base allocation/determination */
 #define NODE_BASELOCK 3
 
-/** How much Process table entries to statically allocate */
-#define MAXPROCS 1024
+/** Default number of children per node of a launch tree */
+#define TREE_FANOUT 4
+
+/** Space between image and heap, for argument rooms mapped by the loader */
+#define ARGROOM_RESERVE ((Elf_Addr)1 << 20)
+
+#ifndef COLOR_STRIDE
+/** Bytes between base colors, the page size and bank interleave of the
+ * simulated memory */
+#define COLOR_STRIDE ((Elf_Addr)1 << 12)
+#endif /* COLOR_STRIDE */
+
+#ifndef COLOR_COUNT
+/** Number of base colors, the memory banks the stride walks over */
+#define COLOR_COUNT 8
+#endif /* COLOR_COUNT */
+
+#ifndef COLOR_BASES
+/** Default base coloring policy, on true bases are staggered */
+#define COLOR_BASES 0
+#endif /* COLOR_BASES */
+
+#ifndef SNAPSHOT_TRIES
+/** Copies of an entry proc_snapshot tries before skipping it */
+#define SNAPSHOT_TRIES 16
+#endif /* SNAPSHOT_TRIES */
+
+/** Version of the Clocks record, after TicksToCleaned follow the phaseticks
+ * (since 2), then the perfdelta counters (since 3) */
+#define CLOCKS_VERSION 3
+
+#if ENABLE_CLOCKCALLS
+/** Starts timing a phase, declares the tick variable Since */
+#define PHASE_BEGIN(Since) clock_t Since = clock()
+/** Adds the ticks since Since to phase Ph of P, then restarts Since */
+#define PHASE_END(P, Ph, Since) do {\
+    clock_t now_ = clock();\
+    (P)->phaseticks[Ph] += now_ - (Since);\
+    (Since) = now_;\
+  } while (0)
+#else
+#define PHASE_BEGIN(Since)
+#define PHASE_END(P, Ph, Since) do {} while (0)
+#endif /* ENABLE_CLOCKCALLS */
 
 /** Indicator of incomplete ELF header, minimum size **/
 #define SANE_SIZE sizeof(struct Elf_Ehdr)
@@ -37,6 +89,15 @@
 /** Master process table, holds an entry for each running process */
 struct admin_s proctable[MAXPROCS];
 
+/** Base coloring policy, set from config */
+int base_coloring = COLOR_BASES;
+
+/** Pids handed out and not pooled, only touched on NODE_BASELOCK */
+int activeprocs = 0;
+
+/** Pids handed out, pooled ones included, only touched on NODE_BASELOCK */
+static int heldprocs = 0;
+
 /** Index in the array/process table which should be free. Initially 1 */
 int nextfreepid = 1;
 
@@ -51,42 +112,228 @@ void init_admins(void){
   nextfreepid = 1;
 }
 
+/** \brief Places a new process, call on NODE_BASELOCK only.
+ * \param p The new process table entry.
+ * \param req The requested placement.
+ **/
+void place_process(struct admin_s *p, const struct admin_s *req){
+  p->core_start = req->core_start;
+  p->core_size = req->core_size;
+
+  if (req->core_start == -1){
+    /* Any place, take the least loaded */
+    int avoid_start = -1;
+    int avoid_size = 0;
+    /* Kept as picked, release has to free the same cores */
+    int size = sched_placesize((req->core_size > 0)?req->core_size:1);
+    int a = req->antiaffinity;
+    if ((a > 0) && (a < MAXPROCS) && (proctable[a].state != proc_free)){
+      avoid_start = proctable[a].core_start;
+      avoid_size = proctable[a].core_size;
+    }
+    p->core_start = sched_pick(size, req->affinity, req->affinity_count,
+                               avoid_start, avoid_size);
+    p->core_size = size;
+  }
+  sched_occupy(p->core_start, p->core_size, 1);
+}
+
 /* Pid/Base allocation code */
-sl_def(slbase_fn,, sl_glparm(struct admin_s**, basep)){
+/** \brief Copies the filename into the entry, callers may free theirs.
+ * \param p The process table entry.
+ * \param fname The requested filename, may be NULL, cut to fit.
+ **/
+static void proc_setname(struct admin_s *p, const char *fname){
+  p->procname[0] = 0;
+  if (fname) strncat(p->procname, fname, LOADER_PROCNAME - 1);
+  p->fname = p->procname;
+}
+
+sl_def(slbase_fn,, sl_glparm(struct admin_s**, basep), sl_glparm(struct admin_s*, req),
+    sl_glparm(int, bits), sl_glparm(unsigned long*, stale_start), sl_glparm(int*, stale_bits),
+    sl_glparm(clock_t, t0)){
 
   /* Sets the pointer to the allocated structure, handles the freelist */
   int npid = nextfreepid;
   struct admin_s **val = sl_getp(basep);
-  *val = &proctable[npid];
-  (*val)->base = base_off + npid * base_progmaxsize;
+  struct admin_s *p = &proctable[npid];
+  int bits = sl_getp(bits);
+  unsigned long start;
+  LOCK_ENTER(lock_pid, sl_getp(t0));
+
+  *val = NULL;
+  *sl_getp(stale_bits) = 0;
+  if (!npid){
+    LOCK_LEAVE(lock_pid);
+    return;
+  }
+
+  /* A held sub-space big enough is kept, its kept pages stay valid */
+  if (p->region_bits < bits){
+    if (region_alloc(bits, &start)){
+      LOCK_LEAVE(lock_pid);
+      return;
+    }
+    if (p->region_bits){
+      /* Its pages are dropped before the old sub-space is handed out */
+      *sl_getp(stale_start) = p->region_start;
+      *sl_getp(stale_bits) = p->region_bits;
+    }
+    p->region_start = start;
+    p->region_bits = bits;
+  }
+
+  PROC_WRITE_BEGIN(p);
+  *val = p;
+  place_process(*val, sl_getp(req));
+  (*val)->base = p->region_start;
+  (*val)->heap_start = 0;
+  proc_setname(*val, sl_getp(req)->fname);
+  memset((*val)->pageclass, 0, sizeof((*val)->pageclass));
+  (*val)->bytes_requested = 0;
+  (*val)->bytes_reserved = 0;
   (*val)->pidnum = npid;
+  (*val)->generation++;
+  (*val)->state = proc_loading;
+  (*val)->exit_code = 0;
+  (*val)->image_end = 0;
+  (*val)->argroom_offset = 0;
+  (*val)->argroom_size = 0;
+  (*val)->envroom_offset = 0;
+  (*val)->envroom_size = 0;
   
   nextfreepid = (*val)->nextfreepid;
   (*val)->nextfreepid = 0;;
+  PROC_WRITE_END(p);
+  activeprocs++;
+  heldprocs++;
+  stats_places.pids_inuse = heldprocs;
+  if (stats_places.pids_inuse > stats_places.pids_highwater){
+    stats_places.pids_highwater = stats_places.pids_inuse;
+  }
+  LOCK_LEAVE(lock_pid);
 }
 sl_enddef
 
 /* Pid deallocation code */
-sl_def(sldelbase_fn,, sl_glparm(int, deadpid)){
+sl_def(sldelbase_fn,, sl_glparm(int, deadpid), sl_glparm(int*, idle), sl_glparm(clock_t, t0)){
 
   /* Reclaims the PID for the system, handles the freelist */
   int npid = nextfreepid;
   int deadpid = sl_getp(deadpid);
   struct admin_s *val = &proctable[deadpid];
+  LOCK_ENTER(lock_pid, sl_getp(t0));
+
+  /* Joinable processes pushed their record at termination already */
+  if (val->cq && !(val->settings & e_joinable)) cq_push(val->cq, val);
+  val->cq = 0;
+  intern_release(val->argshare);
+  intern_release(val->envshare);
+  val->argshare = 0;
+  val->envshare = 0;
+  sched_occupy(val->core_start, val->core_size, -1);
+  PROC_WRITE_BEGIN(val);
   val->pidnum = 0;
+  val->state = proc_free;
+  PROC_WRITE_END(val);
+
+  /* Kept pages pin the sub-space to the pid, it returns once they are gone */
+  if (val->region_bits && !reserve_kept(deadpid)){
+    region_free(val->region_start, val->region_bits);
+    val->region_bits = 0;
+  }
   
   val->nextfreepid = npid;
   nextfreepid = deadpid;
+
+#if ENABLE_CLOCKCALLS
+  /* Serialized here already, the histograms need no lock of their own */
+  if ((val->settings & e_timeit) && val->detachtick &&
+      (val->detachtick >= val->createtick) && (val->lasttick >= val->detachtick)){
+    hist_add(hist_detach, val->detachtick - val->createtick);
+    hist_add(hist_run, val->lasttick - val->detachtick);
+    hist_add(hist_clean, val->cleaneduptick - val->lasttick);
+  }
+  val->detachtick = 0;
+  val->lasttick = 0;
+#endif /* ENABLE_CLOCKCALLS */
+
+  activeprocs--;
+  heldprocs--;
+  stats_places.pids_inuse = heldprocs;
+  *sl_getp(idle) = (activeprocs == 0);
+  LOCK_LEAVE(lock_pid);
+}
+sl_enddef
+
+/** \brief Runs once the last process is reaped, outside of any lock. **/
+static void loader_idle(void){
+  trace_dump();
+#if ENABLE_CLOCKCALLS
+  /* Only runs that asked for timing get a summary */
+  if (hist_counted(hist_detach)){
+    hist_summary();
+    lock_summary();
+  }
+#endif /* ENABLE_CLOCKCALLS */
+}
+
+/* Background cleanup, clears kept pages before the pid is handed out */
+sl_def(slreap_fn,, sl_glparm(int, deadpid)){
+  int deadpid = sl_getp(deadpid);
+  int idle = 0;
+  reserve_zero_pid(deadpid);
+  sl_create(, MAKE_CLUSTER_ADDR(NODE_BASELOCK, 1) ,,,,, sl__exclusive, sldelbase_fn,
+      sl_glarg(int, deadpid, deadpid), sl_glarg(int*, idle, &idle),
+      sl_glarg(clock_t, t0, LOCK_REQUEST()));
+  sl_sync();
+  if (idle) loader_idle();
+}
+sl_enddef
+
+/* Returns a sub-space no pages are mapped in anymore */
+sl_def(slregionfree_fn,, sl_glparm(unsigned long, start), sl_glparm(int, bits), sl_glparm(clock_t, t0)){
+  LOCK_ENTER(lock_pid, sl_getp(t0));
+  region_free(sl_getp(start), sl_getp(bits));
+  LOCK_LEAVE(lock_pid);
+}
+sl_enddef
+
+/* Completion record code, for processes keeping their pid */
+sl_def(slcqpush_fn,, sl_glparm(int, deadpid), sl_glparm(clock_t, t0)){
+  struct admin_s *val = &proctable[sl_getp(deadpid)];
+  LOCK_ENTER(lock_pid, sl_getp(t0));
+  cq_push(val->cq, val);
+  LOCK_LEAVE(lock_pid);
 }
 sl_enddef
 
-/** \brief Generate a new base, PID actually.
- * \param params What structure pointer to update.
- * \return Base address.
+/** \brief Generate a new base, PID actually, and place the process.
+ * \param params What structure pointer to update, NULL when out of pids or
+ * address space.
+ * \param req The requested placement, core_start -1 picks the least loaded.
+ * \param bits Size of the address sub-space, see region_bits.
+ * \return Base address, 0 on failure.
  **/
-Elf_Addr locked_newbase(struct admin_s **params){
-  sl_create(, MAKE_CLUSTER_ADDR(NODE_BASELOCK, 1) ,,,,, sl__exclusive, slbase_fn, sl_glarg(struct admin_s**, params, params));
+Elf_Addr locked_newbase(struct admin_s **params, struct admin_s *req, int bits){
+  unsigned long stale_start = 0;
+  int stale_bits = 0;
+
+  sl_create(, MAKE_CLUSTER_ADDR(NODE_BASELOCK, 1) ,,,,, sl__exclusive, slbase_fn,
+      sl_glarg(struct admin_s**, params, params), sl_glarg(struct admin_s*, req, req),
+      sl_glarg(int, bits, bits), sl_glarg(unsigned long*, stale_start, &stale_start),
+      sl_glarg(int*, stale_bits, &stale_bits), sl_glarg(clock_t, t0, LOCK_REQUEST()));
   sl_sync();
+  if (!*params) return 0;
+
+  if (stale_bits){
+    /* Outgrown, the pages in the old sub-space go before it is reused */
+    reserve_trim_pid((*params)->pidnum);
+    sl_create(, MAKE_CLUSTER_ADDR(NODE_BASELOCK, 1) ,,,,, sl__exclusive, slregionfree_fn,
+        sl_glarg(unsigned long, start, stale_start), sl_glarg(int, bits, stale_bits),
+        sl_glarg(clock_t, t0, LOCK_REQUEST()));
+    sl_sync();
+  }
 
 #if ENABLE_CLOCKCALLS
   /** As soon as possible without blocking others, notes the 'time' */
@@ -96,6 +343,27 @@ Elf_Addr locked_newbase(struct admin_s **params){
   return (*params)->base;
 }
 
+#if ENABLE_CLOCKCALLS
+/** \brief Records the timing of a process as one block of trace events.
+ *  \param p The process, still holding its pid.
+ **/
+static void trace_clocks(const struct admin_s *p){
+  unsigned long seq = trace_reserve(ph_count + pf_count + 4);
+  int ph;
+
+  trace_put(seq++, tr_proc, p->pidnum, p->core_start, p->createtick, p->core_size);
+  for (ph=0;ph<ph_count;ph++){
+    trace_put(seq++, tr_phase, p->pidnum, p->core_start, p->phaseticks[ph], ph);
+  }
+  for (ph=0;ph<pf_count;ph++){
+    trace_put(seq++, tr_perf, p->pidnum, p->core_start, p->perfdelta[ph], ph);
+  }
+  trace_put(seq++, tr_detach, p->pidnum, p->core_start, p->detachtick, 0);
+  trace_put(seq++, tr_end, p->pidnum, p->core_start, p->lasttick, 0);
+  trace_put(seq++, tr_cleaned, p->pidnum, p->core_start, p->cleaneduptick, 0);
+}
+#endif /* ENABLE_CLOCKCALLS */
+
 /** \brief Cleans a process.
  *  \param deadpid Which process to clean.
  **/
@@ -106,11 +374,18 @@ void locked_delbase(int deadpid){
   proctable[deadpid].cleaneduptick = clock();
   if (proctable[deadpid].timecallback) proctable[deadpid].timecallback();
 
+  /** With a trace file, timing data goes to the ring, unformatted. */
+  if ((proctable[deadpid].settings & e_timeit) && trace_path){
+    trace_clocks(&proctable[deadpid]);
+  }
 #  if ENABLE_DEBUG
   /** If requested, prints timing data. */
-  if ((proctable[deadpid].settings & e_timeit)/* || (proctable[deadpid].verbose > VERB_INFO)*/){
+  else if ((proctable[deadpid].settings & e_timeit)/* || (proctable[deadpid].verbose > VERB_INFO)*/){
     char buff[1024];
-    snprintf(buff, 1023, "\n<Clocks>%d,%d,%d,%lu,%lu,%lu,%lu</Clocks>%s\n",
+    int len;
+    int ph;
+    len = snprintf(buff, 1023, "\n<Clocks v%d>%d,%d,%d,%lu,%lu,%lu,%lu",
+        CLOCKS_VERSION,
         deadpid,
         proctable[deadpid].core_start,
         proctable[deadpid].core_size,
@@ -118,7 +393,19 @@ void locked_delbase(int deadpid){
       proctable[deadpid].createtick,
       proctable[deadpid].detachtick - proctable[deadpid].createtick,
       proctable[deadpid].lasttick - proctable[deadpid].createtick,
-      proctable[deadpid].cleaneduptick - proctable[deadpid].createtick,
+      proctable[deadpid].cleaneduptick - proctable[deadpid].createtick
+      );
+    /* Breakdown of TicksToDetach, in e_phase order */
+    for (ph=0;ph<ph_count;ph++){
+      len += snprintf(buff + len, 1023 - len, ",%lu",
+          (unsigned long)proctable[deadpid].phaseticks[ph]);
+    }
+    /* Counters over the main function, in e_perf order */
+    for (ph=0;ph<pf_count;ph++){
+      len += snprintf(buff + len, 1023 - len, ",%ld",
+          proctable[deadpid].perfdelta[ph]);
+    }
+    snprintf(buff + len, 1023 - len, "</Clocks>%s\n",
       ""/*((proctable[deadpid].fname)?(proctable[deadpid].fname):"")*/
       );
     locked_print_string(buff, PRINTERR);
@@ -129,16 +416,139 @@ void locked_delbase(int deadpid){
 
   /* DEALLOC MEMRANGES FIRST OR THEY GO BOOM */
   reserve_cancel_pid(deadpid);
-  sl_create(, MAKE_CLUSTER_ADDR(NODE_BASELOCK, 1) ,,,,, sl__exclusive, sldelbase_fn, sl_glarg(int, deadpid, deadpid));
+
+  if (proctable[deadpid].settings & e_joinable){
+    /* The pid is freed by whoever reaps it */
+    if (proctable[deadpid].cq){
+      sl_create(, MAKE_CLUSTER_ADDR(NODE_BASELOCK, 1) ,,,,, sl__exclusive, slcqpush_fn, sl_glarg(int, deadpid, deadpid),
+          sl_glarg(clock_t, t0, LOCK_REQUEST()));
+      sl_sync();
+    }
+    PROC_WRITE_BEGIN(&proctable[deadpid]);
+    proctable[deadpid].state = proc_zombie;
+    PROC_WRITE_END(&proctable[deadpid]);
+    return;
+  }
+  sl_create(, MAKE_CLUSTER_ADDR(sched_idlest(), 1) ,,,,,, slreap_fn, sl_glarg(int, deadpid, deadpid));
   sl_detach();
 }
 
+/** \brief Waits for a joinable process, frees its pid.
+ * Only one waiter per handle, as with the family it waits on.
+ * \param h The handle returned on spawn.
+ * \param exit_code If set, receives the return value of the main function.
+ * \param flags e_wait_nohang to return instead of blocking.
+ * \return 0 when reaped, 1 when still running and e_wait_nohang is set, -1 on
+ * a stale, invalid or not joinable handle.
+ **/
+int elf_wait(loader_handle_t h, int *exit_code, enum e_waitflags flags){
+  int pid = HANDLE_PID(h);
+  int idle = 0;
+  struct admin_s *p;
+
+  if ((pid <= 0) || (pid >= MAXPROCS)) return -1;
+  p = &proctable[pid];
+
+  /* The generation differs once the pid has been reaped and reused */
+  if ((p->generation != HANDLE_GEN(h)) ||
+      (p->state == proc_free) ||
+      !(p->settings & e_joinable)) return -1;
+
+  if ((flags & e_wait_nohang) && (p->state != proc_zombie)) return 1;
+
+  /* Blocks on the family of the process, not on the table */
+  function_join(pid);
+  if (exit_code) *exit_code = p->exit_code;
+
+  reserve_zero_pid(pid);
+  sl_create(, MAKE_CLUSTER_ADDR(NODE_BASELOCK, 1) ,,,,, sl__exclusive, sldelbase_fn,
+      sl_glarg(int, deadpid, pid), sl_glarg(int*, idle, &idle),
+      sl_glarg(clock_t, t0, LOCK_REQUEST()));
+  sl_sync();
+  if (idle) loader_idle();
+  return 0;
+}
+
+/** \brief Copies the live processes, without stopping the loader.
+ * Each entry is read between two equal, even seq values, an entry that keeps
+ * changing is retried SNAPSHOT_TRIES times and then left out.
+ * \param out Receives the processes, by increasing pid.
+ * \param max Room in out.
+ * \return Number of processes copied.
+ **/
+int proc_snapshot(struct loader_procinfo_s *out, int max){
+  int pid;
+  int n = 0;
+
+  if (!out) return 0;
+  for (pid=1;(pid<MAXPROCS) && (n<max);pid++){
+    struct admin_s *p = &proctable[pid];
+    struct loader_procinfo_s *o = &out[n];
+    unsigned int seq;
+    int tries;
+    int c;
+
+    if (p->state == proc_free) continue;
+    for (tries=0;tries<SNAPSHOT_TRIES;tries++){
+      seq = *(volatile unsigned int*)&p->seq;
+      PROC_BARRIER();
+      if (seq & 1) continue;
+      o->pid = p->pidnum;
+      o->generation = p->generation;
+      o->state = p->state;
+      o->core_start = p->core_start;
+      o->core_size = p->core_size;
+      o->base = p->base;
+      o->heap_start = p->heap_start;
+      o->createtick = p->createtick;
+      o->detachtick = p->detachtick;
+      o->lasttick = p->lasttick;
+      memcpy(o->pageclass, p->pageclass, sizeof(o->pageclass));
+      o->bytes_requested = p->bytes_requested;
+      o->bytes_reserved = p->bytes_reserved;
+      memcpy(o->fname, p->procname, LOADER_PROCNAME);
+      o->fname[LOADER_PROCNAME - 1] = 0;
+      PROC_BARRIER();
+      if (seq == *(volatile unsigned int*)&p->seq) break;
+    }
+    if ((tries == SNAPSHOT_TRIES) || (o->state == proc_free)) continue;
+    o->pages = 0;
+    for (c=0;c<LOADER_PAGECLASSES;c++) o->pages += o->pageclass[c];
+    n++;
+  }
+  return n;
+}
+
+/** \brief Waits for several joinable processes.
+ * Reaped entries are set to 0 in hs, so a nohang caller can simply retry.
+ * \param hs Handles, 0 entries are skipped.
+ * \param count Number of handles.
+ * \param exit_codes If set, receives the exit code per reaped handle.
+ * \param flags e_wait_nohang to only reap those already terminated.
+ * \return Number of processes reaped.
+ **/
+int elf_wait_many(loader_handle_t *hs, int count, int *exit_codes,
+                  enum e_waitflags flags){
+  int i;
+  int reaped = 0;
+  for (i=0;i<count;i++){
+    int code = 0;
+    if (! hs[i]) continue;
+    if (elf_wait(hs[i], &code, flags) == 0){
+      if (exit_codes) exit_codes[i] = code;
+      hs[i] = 0;
+      reaped++;
+    }
+  }
+  return reaped;
+}
+
 /** \brief Loads a file from params.
- * \param params The prered settings.
+ * \param params The prered settings, pidnum and generation are set on success.
  * \param flags Any flags required.
- * \return 0 on success.
+ * \return Handle of the started process, 0 on failure.
  **/
-int elf_loadfile_p(struct admin_s * params, enum e_settings flags){
+loader_handle_t elf_loadfile_p(struct admin_s * params, enum e_settings flags){
   int fin = -1;
   size_t fsize = 0;
   struct stat fstatus;
@@ -148,6 +558,25 @@ int elf_loadfile_p(struct admin_s * params, enum e_settings flags){
   off_t toread;
   int verbose = params->verbose;
   char buff[1024];
+  struct arena_s scratch;
+
+  params->pidnum = 0;
+  params->generation = 0;
+  memset(params->phaseticks, 0, sizeof(params->phaseticks));
+
+  if (!(params->settings & e_topool)){
+    /* A warm instance skips everything up to the argument copy */
+    struct admin_s *p = pool_take(params);
+    if (p){
+#if ENABLE_CLOCKCALLS
+      p->createtick = clock();
+#endif /* ENABLE_CLOCKCALLS */
+      /* Nothing loaded for this launch, only the arguments are timed */
+      memset(p->phaseticks, 0, sizeof(p->phaseticks));
+      if (elf_launch_p(p, params, flags)) return 0;
+      return LOADER_HANDLE(params->pidnum, params->generation);
+    }
+  }
 
 #if ENABLE_DEBUG
   if (verbose > VERB_INFO){
@@ -156,6 +585,7 @@ int elf_loadfile_p(struct admin_s * params, enum e_settings flags){
   }
 #endif /* ENABLE_DEBUG */
 
+  PHASE_BEGIN(since);
   fin = open(params->fname, O_RDONLY);
   if (-1 == fin){
 
@@ -167,6 +597,7 @@ int elf_loadfile_p(struct admin_s * params, enum e_settings flags){
     }
 #endif /* ENABLE_DEBUG */
 
+    STAT_ADD(0, loads_failed, 1);
     return 0;
   }
   if (fstat(fin, &fstatus)) {
@@ -179,6 +610,7 @@ int elf_loadfile_p(struct admin_s * params, enum e_settings flags){
     }
 #endif /* ENABLE_DEBUG */
 
+    STAT_ADD(0, loads_failed, 1);
     return 0;
   }
 
@@ -189,15 +621,25 @@ int elf_loadfile_p(struct admin_s * params, enum e_settings flags){
     if (verbose > VERB_ERR) locked_print_string("Filesize too small, not a valid file\n", PRINTERR);
 #endif /* ENABLE_DEBUG */
 
+    STAT_ADD(0, loads_failed, 1);
     return 0;
   }
 
+  PHASE_END(params, ph_open, since);
+
 #if ENABLE_DEBUG
   if (verbose > VERB_INFO) locked_print_string("File opened\n", PRINTERR);
 #endif /* ENABLE_DEBUG */
 
-  /* Allocate temporary storage */
-  fdata = malloc(fsize);
+  /* Allocate temporary storage, released in one go after the spawn */
+  arena_open(&scratch, params->arenaslot);
+  fdata = arena_alloc(&scratch, fsize);
+  if (!fdata){
+    arena_close(&scratch);
+    close(fin);
+    STAT_ADD(0, loads_failed, 1);
+    return 0;
+  }
   sr = 0;
   toread = fsize;
   while (toread > 0){
@@ -220,6 +662,9 @@ int elf_loadfile_p(struct admin_s * params, enum e_settings flags){
       }
 #endif /* ENABLE_DEBUG */
 
+      arena_close(&scratch);
+      close(fin);
+      STAT_ADD(0, loads_failed, 1);
       return 0;
     }
   }
@@ -231,6 +676,7 @@ int elf_loadfile_p(struct admin_s * params, enum e_settings flags){
   close(fin);
   fin = -1;
   /*File closed*/
+  PHASE_END(params, ph_read, since);
 
   if (elf_loadprogram_p(fdata, fsize,
         flags,
@@ -241,10 +687,21 @@ int elf_loadfile_p(struct admin_s * params, enum e_settings flags){
     if (verbose > VERB_ERR) locked_print_string("Elf failure\n", PRINTERR);
 #endif /* ENABLE_DEBUG */
 
+    arena_close(&scratch);
+    return 0;
   }
   
-  free(fdata);
-  return 0;
+  arena_close(&scratch);
+
+#if ENABLE_DEBUG
+  if (verbose > VERB_INFO){
+    snprintf(buff, 1023, "Scratch peak %lu bytes\n",
+             (unsigned long)arena_peak(params->arenaslot));
+    locked_print_string(buff, PRINTERR);
+  }
+#endif /* ENABLE_DEBUG */
+
+  return LOADER_HANDLE(params->pidnum, params->generation);
 }
 
 /** \brief Loads from C like parameters.
@@ -254,13 +711,16 @@ int elf_loadfile_p(struct admin_s * params, enum e_settings flags){
  * \param argv String pointer array.
  * \param env Environment, terminated by double nullbyte, strings seperated by
  * single nullbyte.
- * \return 0 on success.
+ * \return Handle of the started process, 0 on failure.
  **/
-int elf_loadfile(const char *fname, enum e_settings flags,
+loader_handle_t elf_loadfile(const char *fname, enum e_settings flags,
               int argc, char **argv, char* env){
 
   struct admin_s params;
-  params.fname = strdup(fname);
+  ZERO_ADMINP(&params);
+  /* The loader keeps its own copy once the pid is taken */
+  params.fname = (char*)fname;
+  params.settings = flags;
   params.base = 0;
   params.core_start = -1;
   params.core_size = -1;
@@ -272,6 +732,117 @@ int elf_loadfile(const char *fname, enum e_settings flags,
   return elf_loadfile_p(&params, flags);
 }
 
+/* Tree launch node, loads the head of its list and forks the remainder */
+sl_decl(sltree_fn,, sl_glparm(struct admin_s*, list), sl_glparm(int, count),
+                    sl_glparm(int, fanout), sl_glparm(int, level),
+                    sl_glparm(unsigned long, flags),
+                    sl_glparm(loader_levelcb_t*, levelcb));
+
+/* Tree launch fork, thread N forwards the Nth chunk of the list to its core */
+sl_def(sltreefork_fn,, sl_glparm(struct admin_s*, list), sl_glparm(int, count),
+                       sl_glparm(int, chunk),
+                       sl_glparm(int, fanout), sl_glparm(int, level),
+                       sl_glparm(unsigned long, flags),
+                       sl_glparm(loader_levelcb_t*, levelcb)){
+  sl_index(j);
+  int chunk = sl_getp(chunk);
+  int count = sl_getp(count) - j * chunk;
+  struct admin_s *sub = sl_getp(list) + j * chunk;
+
+  if (count > chunk) count = chunk;
+  if (count > 0){
+    /* The subtree runs on the core of its first entry */
+    int cad = MAKE_CLUSTER_ADDR(sub->core_start, 1);
+    cad = (sub->core_start == -1)?0:cad;
+
+    sl_create(, cad,,,,,, sltree_fn,
+        sl_glarg(struct admin_s*, , sub),
+        sl_glarg(int, , count),
+        sl_glarg(int, , sl_getp(fanout)),
+        sl_glarg(int, , sl_getp(level)),
+        sl_glarg(unsigned long, , sl_getp(flags)),
+        sl_glarg(loader_levelcb_t*, , sl_getp(levelcb)));
+    sl_sync();
+  }
+}
+sl_enddef
+
+sl_def(sltree_fn,, sl_glparm(struct admin_s*, list), sl_glparm(int, count),
+                   sl_glparm(int, fanout), sl_glparm(int, level),
+                   sl_glparm(unsigned long, flags),
+                   sl_glparm(loader_levelcb_t*, levelcb)){
+  struct admin_s *list = sl_getp(list);
+  int count = sl_getp(count);
+  int fanout = sl_getp(fanout);
+  int level = sl_getp(level);
+  loader_levelcb_t *levelcb = sl_getp(levelcb);
+  int rest = count - 1;
+
+#if ENABLE_CLOCKCALLS
+  if (levelcb) levelcb(list, level, clock());
+#endif /* ENABLE_CLOCKCALLS */
+
+  if (rest > 0){
+    /* Fork first, so the subtrees start while this node loads its own entry */
+    int k = (rest < fanout)?rest:fanout;
+    int chunk = (rest + k - 1) / k;
+    sl_create(,, 0, k, 1,,, sltreefork_fn,
+        sl_glarg(struct admin_s*, , list + 1),
+        sl_glarg(int, , rest),
+        sl_glarg(int, , chunk),
+        sl_glarg(int, , fanout),
+        sl_glarg(int, , level + 1),
+        sl_glarg(unsigned long, , sl_getp(flags)),
+        sl_glarg(loader_levelcb_t*, , levelcb));
+
+    list->launchlevel = level;
+    if (!elf_loadfile_p(list, sl_getp(flags))) list->pidnum = 0;
+    sl_sync();
+  } else {
+    list->launchlevel = level;
+    if (!elf_loadfile_p(list, sl_getp(flags))) list->pidnum = 0;
+  }
+}
+sl_enddef
+
+/** \brief Loads a list of programs as a launch tree.
+ * Each node of the tree loads one entry and forwards the remainder of its part
+ * of the list, split over at most fanout children, each running on the core
+ * of the first entry of their part. Time to last start grows with the depth
+ * of the tree instead of the length of the list.
+ * \param list The prepared settings, one entry per program.
+ * \param count Number of entries in list.
+ * \param fanout Children per tree node, values below 2 use TREE_FANOUT.
+ * \param flags Any flags required.
+ * \param levelcb If set, called with the level and start time of each node.
+ * \return Number of entries that failed to load, so 0 on success, -1 on
+ * invalid arguments. Returns after every entry has been started, the pidnum
+ * of a failed entry is 0.
+ **/
+int elf_loadtree_p(struct admin_s *list, int count, int fanout,
+                   enum e_settings flags, loader_levelcb_t *levelcb){
+  int failed = 0;
+  int i;
+
+  if (!list || count <= 0) return -1;
+  if (fanout < 2) fanout = TREE_FANOUT;
+
+  sl_create(,,,,,,, sltree_fn,
+      sl_glarg(struct admin_s*, , list),
+      sl_glarg(int, , count),
+      sl_glarg(int, , fanout),
+      sl_glarg(int, , 0),
+      sl_glarg(unsigned long, , flags),
+      sl_glarg(loader_levelcb_t*, , levelcb));
+  sl_sync();
+
+  /* Each node left the outcome in its own entry */
+  for (i=0;i<count;i++){
+    if (!list[i].pidnum) failed++;
+  }
+  return failed;
+}
+
 /** \brief Byte order. 
  * \param dstart ELF data pointer.
  * \param size ELF image size.
@@ -460,6 +1031,39 @@ Elf_Addr elf_findbase_marshallphdr(char *dstart, size_t size){
   return base;
 }
 
+/** \brief Color of a process base.
+ * Neighbouring cores, and processes sharing a core, get different colors.
+ * \param p The placed process.
+ * \return Color, below COLOR_COUNT.
+ **/
+static int base_color(const struct admin_s *p){
+  int core = (p->core_start > 0) ? p->core_start : 0;
+  return (core + p->pidnum) % COLOR_COUNT;
+}
+
+/** \brief Size of the image as mapped, from the sub-space start.
+ * \param dstart ELF image pointer, program headers marshalled.
+ * \param size ELF image size.
+ * \param relbase Lowest segment address, from elf_findbase_marshallphdr.
+ * \return End of the last page elf_loadit maps, relative to the sub-space.
+ **/
+Elf_Addr elf_span(char *dstart, size_t size, Elf_Addr relbase){
+  struct Elf_Ehdr *ehdr = (struct Elf_Ehdr*)dstart;
+  struct Elf_Phdr *phdr = (struct Elf_Phdr*) (dstart + ehdr->e_phoff);
+  Elf_Addr end = 0;
+  Elf_Half i;
+
+  (void) size;
+  for (i=0; i < ehdr->e_phnum; ++i){
+    if (phdr[i].p_type == PT_LOAD && phdr[i].p_memsz > 0){
+      Elf_Addr e = phdr[i].p_vaddr + reserve_span(phdr[i].p_memsz);
+      if (e > end) end = e;
+    }
+  }
+  /* The base is moved up by relbase, then page aligned */
+  return relbase + end;
+}
+
 /** \brief Loads from read ELF file.
  * \param dstart ELF image pointer.
  * \param size ELF image size.
@@ -474,6 +1078,10 @@ int elf_loadit(char *dstart, size_t size, struct admin_s* adminstart){
   Elf_Half i;
   long pid = adminstart->pidnum;
   char buff[1024];
+  /* Cleared as soon as any segment got pages with unknown contents */
+  int allzero = 1;
+  int zero;
+  char *end;
 
 #if ENABLE_DEBUG
   if (verbose > VERB_INFO) {
@@ -528,10 +1136,16 @@ int elf_loadit(char *dstart, size_t size, struct admin_s* adminstart){
 #endif /* ENABLE_DEBUG */
 
       //reserve, prepare data
-      reserve_range(act_addr, phdr[i].p_memsz, perm |
+      PHASE_BEGIN(since);
+      end = reserve_range_z(act_addr, phdr[i].p_memsz, perm |
           perm_read|perm_write|perm_exec,
-          pid
+          pid, &zero
           );
+      PHASE_END(adminstart, ph_reserve, since);
+      allzero = allzero && zero;
+      if ((Elf_Addr)end > adminstart->image_end){
+        adminstart->image_end = (Elf_Addr)end;
+      }
       /**
        * Permissions are currently ALL, due to setting the contents, and the 
        * backing code is not quite permission friendly yet...
@@ -540,15 +1154,19 @@ int elf_loadit(char *dstart, size_t size, struct admin_s* adminstart){
       //If there is at least some data, copy it
       if (phdr[i].p_filesz){
         memcpy(act_addr, dstart + phdr[i].p_offset, phdr[i].p_filesz);
+        STAT_ADD(pid, bytes_copied, phdr[i].p_filesz);
       }
 
       //If there is no data but room reserved (per spec: p_filesz < p_memsz
       //which is even valid for no file data at all)
       Elf_Addr deltasize = phdr[i].p_memsz - phdr[i].p_filesz;
-      if (phdr[i].p_filesz < phdr[i].p_memsz){
+      //Pages cleared in the background need no second pass
+      if ((phdr[i].p_filesz < phdr[i].p_memsz) && !allzero){
         //beyond the supplied data, 0 as per spec
         memset(act_addr + phdr[i].p_filesz, 0, deltasize);
+        STAT_ADD(pid, bytes_zeroed, deltasize);
       }
+      PHASE_END(adminstart, ph_copy, since);
 
 #if ENABLE_DEBUG
       if (verbose > VERB_TRACE){
@@ -677,6 +1295,10 @@ int elf_sectionscan(char *dstart, size_t size, struct admin_s* adminstart, int v
   struct Elf_Shdr*  symsect = NULL;
   Elf_Half i;
   char buff[1024];
+  /* Counted locally, added once the scan is done */
+  unsigned long nsyms = 0;
+  unsigned long nrel[STATS_RELOCTYPES] = {0};
+  PHASE_BEGIN(since);
   if (sectsize != sizeof(struct Elf_Shdr)){
 
 #if ENABLE_DEBUG
@@ -783,6 +1405,7 @@ int elf_sectionscan(char *dstart, size_t size, struct admin_s* adminstart, int v
 #endif /* ENABLE_DEBUG */
 
           c++;
+          nsyms++;
           r += s->sh_entsize;
         }
         break;
@@ -811,6 +1434,8 @@ int elf_sectionscan(char *dstart, size_t size, struct admin_s* adminstart, int v
     }
   }
 
+  PHASE_END(adminstart, ph_scan, since);
+
   for (i=0;i<nr_relocs;i++){
     struct Elf_Shdr *s = (struct Elf_Shdr*) (dstart + ehdr->e_shoff + (relocs[i] * sectsize));
     unsigned int r=0;
@@ -894,153 +1519,198 @@ int elf_sectionscan(char *dstart, size_t size, struct admin_s* adminstart, int v
 
       *vicloc = newval;
 
+      switch (rtype){
+        case (ELF_RR_GLOBDAT):
+          nrel[0]++;
+          break;
+        case (ELF_RR_RELATIVE):
+          nrel[1]++;
+          break;
+        case (ELF_RR_JMPSLOT):
+          nrel[2]++;
+          break;
+        default:
+          nrel[STATS_RELOCTYPES - 1]++;
+          break;
+      }
+
       r += s->sh_entsize;
     }
   }
+  PHASE_END(adminstart, ph_reloc, since);
+  STAT_ADD(adminstart->pidnum, symbols, nsyms);
+  for (i=0;i<STATS_RELOCTYPES;i++){
+    STAT_ADD(adminstart->pidnum, relocs[i], nrel[i]);
+  }
   return 0;
 }
  
 /** \brief Spawn a (loaded) program.
- * \param dstart Data start.
- * \param size Data size.
- * \param adminstart Where adminstration resides.
+ * \param adminstart Where adminstration resides, entry set.
  * \param verbose Wheter to spam with errors.
  * \param flags Any required flags.
  * \return 0 on succes.
  **/
-int elf_spawn(char *dstart, size_t size, struct admin_s *adminstart,
+int elf_spawn(struct admin_s *adminstart,
               int verbose, enum e_settings flags){
-  Elf_Addr base = adminstart->base;
-  struct Elf_Ehdr *ehdr = (struct Elf_Ehdr*)dstart;
 
 #if ENABLE_DEBUG
   if (verbose > VERB_INFO) {
     char buff[1024];
-    snprintf(buff, 1023, "Spawning program from %p of size %p with flags %d\n", (void*)dstart, (void*) size, flags);
+    snprintf(buff, 1023, "Spawning program at %p with flags %d\n", (void*)adminstart->entry, flags);
     locked_print_string(buff, PRINTERR);
   }
 #endif /* ENABLE_DEBUG */
 
-  function_spawn((main_function_t*) ((char*)base + ehdr->e_entry),
+  function_spawn((main_function_t*) adminstart->entry,
                  adminstart);
   return 0;
 }
 
-/** \brief String size, inlcudes \0
- * \param in Which string to size.
- * \return Size of a string, including null.
- **/
-static size_t strsize(char *in){
-  size_t s = 0;
-  while (in && in[s]){ s++; }
-  return s + 1;//Null byte inc.
-}
-
-/** \brief Checks the size of arguments and allotted storage.
+/** \brief Lays out argv pointers and strings in the argument room.
+ * Strings are measured and copied in the same walk, once the room turns out
+ * too small the walk only measures.
+ * \param p The process, receives argc and argv when it fits.
  * \param argc As requested
  * \param argv As requested
- * \param envp As requested
- * \param asize Available argument space
- * \param esize Available environment space
- * \param verbose Wheter to spawn warnings
- * \return 0 on success, 1 on ArgumentsTooLarge, 2 on EnvironmentTooLarge, 3 on
- * BothTooLarge.
+ * \param need Receives the bytes the layout takes.
+ * \return 0 when laid out, 1 when the room is too small.
  **/
-int argsizecheck(int argc, char** argv,char * envp, Elf_Addr asize, Elf_Addr esize, int verbose){
-  int i=0;
-  int rv = 0;
-  size_t si = sizeof(char*) * (1 + argc);
-  //Argv
+static int marshal_args(struct admin_s *p, int argc, char **argv,
+                        size_t *need){
+  char **acpp = (char**)p->argroom_offset;
+  size_t si = sizeof(char*) * (argc + 1);
+  int fits = (si <= p->argroom_size);
+  int i;
+
   for (i=0;i<argc;i++){
-    si += strsize(argv[i]);
-  }
-  if (si > asize){
-    rv |= 1;
+    size_t len = argv[i] ? strlen(argv[i]) : 0;
+    if (fits && (si + len + 1 <= p->argroom_size)){
+      char *cpnt = (char*)p->argroom_offset + si;
+      memcpy(cpnt, argv[i], len);
+      cpnt[len] = 0;
+      acpp[i] = cpnt;
+    } else {
+      fits = 0;
+    }
+    si += len + 1;
   }
 
-#if ENABLE_DEBUG
-    if (verbose > VERB_ERR) {
-      char buff[1024];
-      snprintf(buff,1023, "Argroom needed %lu, %lu available\n",si, asize);
-      locked_print_string(buff, PRINTERR);
-    }
-#endif /* ENABLE_DEBUG */
+  *need = si;
+  if (!fits) return 1;
+  acpp[argc] = NULL;
+  p->argc = argc;
+  p->argv = acpp;
+  return 0;
+}
 
-  si = 0;
-  i = 0;
-  while (envp && (envp[i] || envp[i+1])){
-    i++;
-    si++;
-  }
+/** \brief Copies the double nullbyte terminated environment into its room.
+ * \param p The process, receives envp when it fits.
+ * \param envp As requested.
+ * \param need Receives the bytes the block takes.
+ * \return 0 when copied, 1 when the room is too small.
+ **/
+static int marshal_env(struct admin_s *p, char *envp, size_t *need){
+  size_t si = 0;
+  while (envp[si] || envp[si+1]) si++;
   si += 2;
 
+  *need = si;
+  if (si > p->envroom_size) return 1;
+  memcpy((char*)p->envroom_offset, envp, si);
+  p->envp = (char*)p->envroom_offset;
+  return 0;
+}
 
-  if (si > esize){
-    rv |= 2;
+/** \brief Maps rooms next to the image when the linked ones fall short.
+ * Images linked without argroom.o/envroom.o, or with too small rooms, get
+ * pid owned pages right after the last loaded segment.
+ * \param p The loaded process.
+ * \param aneed Bytes needed for arguments, 0 to keep the current room.
+ * \param eneed Bytes needed for the environment, 0 to keep the current room.
+ * \return 0 on success.
+ **/
+static int argroom_dynamic(struct admin_s *p, size_t aneed, size_t eneed){
+  /** Rooms start page aligned, envp follows argv word aligned */
+  static const Elf_Addr PAGE_SIZE = 4096;
+  size_t asize = (aneed + 7) & ~(size_t)7;
+  Elf_Addr start;
+  char *end;
+
+  start = (p->image_end + PAGE_SIZE - 1) & -PAGE_SIZE;
+  if (start + reserve_span(asize + eneed) > p->heap_start) return -1;
+  end = reserve_range((void*)start, asize + eneed, perm_read|perm_write,
+                      p->pidnum);
+  if (!end) return -1;
+  p->image_end = (Elf_Addr)end;
+
+  if (aneed){
+    p->argroom_offset = start;
+    p->argroom_size = aneed;
+    start += asize;
   }
-
-#if ENABLE_DEBUG
-    if (verbose > VERB_ERR) {
-      char buff[1024];
-      snprintf(buff,1023, "Envroom needed %lu, %lu available\n",si, esize);
-      locked_print_string(buff, PRINTERR);
-    }
-#endif /* ENABLE_DEBUG */
-
-  return rv;
+  if (eneed){
+    p->envroom_offset = start;
+    p->envroom_size = eneed;
+  }
+  return 0;
 }
 
-/** \brief Saves args and environment.
- * \param ab The process entry.
+/** \brief Marshals args and environment into the rooms of a process.
+ * Shared blocks are used unless the process asked for private ones.
+ * Whatever does not fit the linked rooms goes to a room mapped next to the
+ * image, whatever cannot be placed at all is dropped.
+ * \param p The process entry, receives argc, argv, envp and argbytes.
  * \param argc As requested.
  * \param argv As requested.
  * \param envp As requested.
- * \return 0 on success.
+ * \param share Whether shared blocks may be used.
+ * \return Bytes marshalled, -1 if anything was dropped.
  **/
-int argsave(struct admin_s *ab,int argc, char** argv,char * envp){
-  //Argv
-  if (ab->argroom_size && argv){
-    int i=0;
-    char **acpp = (char **)ab->argroom_offset;
-    char *cpnt = (char*) (ab->argroom_offset + (sizeof(char*) *(argc + 1)));
-
-    ab->argc = argc;
-    ab->argv = acpp;
-    for (i=0;i<argc;i++){
-      /*For each arugment, copy it, terminate it, and move on*/
-      int k;
-      acpp[i] = cpnt;
-      acpp[i+1] = NULL;
-      *cpnt = 0;
-  
-      //Now copy the string
-      k = 0;
-      while (argv && argv[i] && (argv[i])[k]){
-        *cpnt = (argv[i])[k];
-        cpnt++;
-        *cpnt = 0;
-        k++;
-      }
-      cpnt++;//Room for nullbyte at arg end
+static long argmarshal(struct admin_s *p, int argc, char **argv, char *envp,
+                       int share){
+  size_t aneed = 0;
+  size_t eneed = 0;
+  int amiss = 0;
+  int emiss = 0;
+  int dropped = 0;
+
+  if (share){
+    char **sv = argv ? intern_args(argc, argv, &p->argshare) : NULL;
+    char *se = envp ? intern_env(envp, &p->envshare) : NULL;
+    if (sv){
+      p->argc = argc;
+      p->argv = sv;
+      argv = NULL;
     }
-    cpnt++;
-  }
-
-  /*For all environment, copy and terminate*/
-  if (ab->envroom_size && envp){
-    char *cpnt;
-    int i = 0;
-    ab->envp = (char*)ab->envroom_offset;
-    cpnt = ab->envp;
-    while (envp && (envp[i] || envp[i+1])){
-      cpnt[i] = envp[i];
-      i++;
+    if (se){
+      p->envp = se;
+      envp = NULL;
     }
-    cpnt[i] = 0;
-    cpnt[i+1] = 0;
   }
 
-  return 0;
+  if (argv) amiss = marshal_args(p, argc, argv, &aneed);
+  if (envp) emiss = marshal_env(p, envp, &eneed);
+
+  if (amiss || emiss){
+    if (argroom_dynamic(p, amiss ? aneed : 0, emiss ? eneed : 0)){
+      dropped = 1;
+    } else {
+      if (amiss) amiss = marshal_args(p, argc, argv, &aneed);
+      if (emiss) emiss = marshal_env(p, envp, &eneed);
+    }
+  }
+  if (amiss){
+    aneed = 0;
+    dropped = 1;
+  }
+  if (emiss){
+    eneed = 0;
+    dropped = 1;
+  }
+
+  p->argbytes = aneed + eneed;
+  return dropped ? -1 : (long)p->argbytes;
 }
 
 /** \brief Load the program image into the memory and spawn.
@@ -1058,11 +1728,13 @@ int elf_loadprogram(char* data, size_t size, int verbose,
                     int argc, char **argv, char *envp
                     ){
   struct admin_s params;
+  ZERO_ADMINP(&params);
   params.fname = NULL;
   params.base = 0;
   params.core_start = -1;
   params.core_size = -1;
   params.verbose = verbose;
+  params.settings = flags;
 
   params.argc = argc;
   params.argv = argv;
@@ -1071,19 +1743,34 @@ int elf_loadprogram(char* data, size_t size, int verbose,
   return elf_loadprogram_p(data, size, flags, &params);
 }
 
+/** \brief Releases the pid of a load that failed after locked_newbase.
+ * Goes through the normal teardown, as a process that never ran: its pages
+ * and sub-space are dropped, its cores and pid are released.
+ * \param p The entry handed out for the load.
+ **/
+static void elf_loadfailed(struct admin_s *p){
+  /* No handle was returned and no record is wanted for it */
+  p->settings &= ~(e_joinable | e_timeit);
+  p->cq = 0;
+  STAT_ADD(p->pidnum, loads_failed, 1);
+  locked_delbase(p->pidnum);
+}
+
 /** \brief Load the program from image and spawn.
  * \param data Data pointer.
  * \param size Data size.
  * \param flags Any requested flags.
- * \param params The prepared settings.
+ * \param params The prepared settings, receives pidnum and generation.
  * \return 0 on success.
  **/
 int elf_loadprogram_p(char *data, size_t size,
     enum e_settings flags, struct admin_s * params){
   Elf_Addr relbase;
+  Elf_Addr span;
+  Elf_Addr heapsize;
   struct admin_s *p = NULL;
   int verbose = params->verbose;
-  locked_newbase(&p);
+  PHASE_BEGIN(since);
   
   if (elf_header_marshall(data,size)){
 
@@ -1091,6 +1778,7 @@ int elf_loadprogram_p(char *data, size_t size,
     if (verbose > VERB_ERR) locked_print_string("Marshalling failed\n", PRINTERR);
 #endif /* ENABLE_DEBUG */
 
+    STAT_ADD(0, loads_failed, 1);
     return -1;
   }
   if (elf_header_check(data,size, verbose)){
@@ -1099,6 +1787,7 @@ int elf_loadprogram_p(char *data, size_t size,
     if (verbose > VERB_ERR) locked_print_string("Header checking failed\n", PRINTERR);
 #endif /* ENABLE_DEBUG */
 
+    STAT_ADD(0, loads_failed, 1);
     return -1;
   }
 
@@ -1108,6 +1797,7 @@ int elf_loadprogram_p(char *data, size_t size,
     if (verbose > VERB_ERR) locked_print_string("Architecture check failed\n", PRINTERR);
 #endif /* ENABLE_DEBUG */
 
+    STAT_ADD(0, loads_failed, 1);
     return -1;
   }
 
@@ -1120,20 +1810,46 @@ int elf_loadprogram_p(char *data, size_t size,
     locked_print_string(buff, PRINTERR);
   }
 #endif /* ENABLE_DEBUG */
+
+  PHASE_END(params, ph_check, since);
+
+  /* Sub-space: image as mapped, argument rooms, then the heap */
+  span = elf_span(data, size, relbase) + ARGROOM_RESERVE;
+  if (base_coloring) span += COLOR_COUNT * COLOR_STRIDE;
+  span = (span + HEAP_GROW - 1) & ~(Elf_Addr)(HEAP_GROW - 1);
+  heapsize = params->heap_size ? params->heap_size : HEAP_DEFAULT;
+  locked_newbase(&p, params, region_bits(span + heapsize));
+  if (!p){
+
+#if ENABLE_DEBUG
+    if (verbose > VERB_ERR) locked_print_string("No pid or address space left\n", PRINTERR);
+#endif /* ENABLE_DEBUG */
+
+    STAT_ADD(0, loads_failed, 1);
+    return -1;
+  }
+  p->heap_start = p->region_start + span;
+  STAT_ADD(p->pidnum, loads_started, 1);
+  STAT_ADD(p->pidnum, bytes_read, size);
+  PHASE_END(params, ph_pid, since);
+  /* Phases up to here ran before the pid existed */
+  memcpy(p->phaseticks, params->phaseticks, sizeof(p->phaseticks));
   
 
-  //Set transferable settings
-  p->fname = params->fname;
-  p->core_start = params->core_start;
-  p->core_size = params->core_size;
+  //Set transferable settings, fname was copied with the pid
   p->verbose = params->verbose;
   p->settings = params->settings;
+  p->launchlevel = params->launchlevel;
+  p->cq = params->cq;
 
   p->base += relbase;//correct for elf base
   //force Allignment
   /** Alligment on possible page size */
   static const int PAGE_SIZE = 4096;
   p->base = p->base & -PAGE_SIZE;
+
+  /* Staggered, so images running side by side use different banks */
+  if (base_coloring) p->base += base_color(p) * COLOR_STRIDE;
   
 #if ENABLE_DEBUG
   if (verbose > VERB_TRACE) {
@@ -1147,6 +1863,7 @@ int elf_loadprogram_p(char *data, size_t size,
 #if ENABLE_DEBUG
     if (verbose > VERB_ERR)  locked_print_string("Elf loading failed\n", PRINTERR);
 #endif /* ENABLE_DEBUG */
+    elf_loadfailed(p);
     return -1;
   }
 
@@ -1154,49 +1871,74 @@ int elf_loadprogram_p(char *data, size_t size,
 #if ENABLE_DEBUG
     if (verbose > VERB_ERR) locked_print_string("Elf sections failed\n", PRINTERR);
 #endif /* ENABLE_DEBUG */
+    elf_loadfailed(p);
     return -1;
   }
 
 
+  p->entry = p->base + ((struct Elf_Ehdr*)data)->e_entry;
+
+  if (params->settings & e_topool){
+    /* Loaded and relocated, parked until a spawn takes it */
+    params->pidnum = p->pidnum;
+    params->generation = p->generation;
+    if (pool_put(p)) locked_delbase(p->pidnum);
+    return 0;
+  }
+
+  return elf_launch_p(p, params, flags);
+}
+
+/** \brief Hands a loaded process its arguments and transfers control.
+ * \param p The loaded process, from elf_loadprogram_p or the warm pool.
+ * \param params The prepared settings, receives pidnum and generation.
+ * \param flags Any requested flags.
+ * \return 0 on success.
+ **/
+int elf_launch_p(struct admin_s *p, struct admin_s *params,
+                 enum e_settings flags){
+  int verbose = params->verbose;
+
+  //Set transferable settings, again for pooled instances
+  p->verbose = params->verbose;
+  p->settings = params->settings;
+  p->launchlevel = params->launchlevel;
+  p->cq = params->cq;
+
+  PHASE_BEGIN(since);
+
   //magic loading, fallback to NO ARGS:
   p->argc = 0;
   p->argv = NULL;
   p->envp = NULL;
-  
-  int sizechecks = argsizecheck(params->argc, params->argv, params->envp, p->argroom_size, p->envroom_size,  verbose);
-  if (sizechecks & 1){//Argroom NO
+  p->argbytes = 0;
+
+  if ((params->argv || params->envp) &&
+      (argmarshal(p, params->argc, params->argv, params->envp,
+                  ((p->settings | flags) & e_sharedargs) != 0) < 0)){
 #if ENABLE_DEBUG
-    if (verbose > VERB_ERR) {
+    if (verbose > VERB_ERR){
       locked_print_string("Arguments while not enough room available\n", PRINTERR);
     }
 #endif /* ENABLE_DEBUG */
-    params->argc = 0;
-    params->argv = NULL;
   }
-  if (sizechecks & 2){//Envroom NO
-#if ENABLE_DEBUG
-    if (verbose > VERB_ERR) {
-      locked_print_string("Environment while not enough room available\n", PRINTERR);
-    }
-#endif /* ENABLE_DEBUG */
-    params->argc = 0;
-    params->argv = NULL;
-  }
-  if (params->argv || params->envp){
-    if (argsave(p,
-                params->argc,
-                params->argv,
-                params->envp)){
+  p->phaseticks[ph_args] = 0;
+  PHASE_END(p, ph_args, since);
+
 #if ENABLE_DEBUG
-      if (verbose > VERB_ERR){
-        locked_print_string("Problem in argument construction\n", PRINTERR);
-      }
-#endif /* ENABLE_DEBUG */
-      
-    }
+  if (verbose > VERB_TRACE){
+    char buff[1024];
+    snprintf(buff, 1023, "Marshalled %lu bytes of arguments\n",
+             (unsigned long)p->argbytes);
+    locked_print_string(buff, PRINTERR);
   }
-  
-  if (elf_spawn(data, size, p, verbose, flags)){
+#endif /* ENABLE_DEBUG */
+
+  /* Noted before control transfer, a detached process may be gone after */
+  params->pidnum = p->pidnum;
+  params->generation = p->generation;
+
+  if (elf_spawn(p, verbose, flags)){
 #if ENABLE_DEBUG
     if (verbose > VERB_ERR) locked_print_string("Elf spawning failed\n", PRINTERR);
 #endif /* ENABLE_DEBUG */
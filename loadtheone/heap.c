@@ -0,0 +1,372 @@
+/**
+ * \file heap.c
+ * \brief File housing the heap of loaded programs.
+ *  Leendert van Duijn
+ *  UvA
+ *
+ *  Each process gets a heap at the end of its own address sub-space, after
+ *  the image and argument rooms, mapped on demand with its pid. Small blocks
+ *  come from size class free lists, larger ones from a first fit list, both
+ *  fed by a bump pointer.
+ *  Operations on a heap are serialized on a lock core picked by pid, so
+ *  processes do not contend with each other or with the global malloc.
+ *  Small blocks are first looked for in a cache of the pid, serialized on a
+ *  core of its own that never maps memory or walks the large list, so it is
+ *  not held up by a heap that grows. Process cores are never used for it, an
+ *  e_exclusive process holds the exclusive context of its core. The heap lock
+ *  core is only visited to refill or drain that cache in batches, and for
+ *  large blocks.
+ *
+ **/
+
+#include <string.h>
+
+#include <svp/mgsim.h>
+#include <svp/abort.h>
+
+#include "ELF.h"
+#include "basfunc.h"
+#include "loader.h"
+#include "heap.h"
+
+/** Number of small size classes, 16 up to 2048 bytes */
+#define HEAP_CLASSES 8
+
+/** Lock place of the heap of a pid */
+#define HEAP_PLACE(Pid) \
+  MAKE_CLUSTER_ADDR(HEAP_FIRSTCORE + ((Pid) % HEAP_NCORES), 1)
+
+/** Fresh bytes a refill carves at most, beyond its first block */
+#define HEAP_REFILL_BYTES 4096
+
+/** Place of the block cache of a pid */
+#define HEAP_CACHE_PLACE(Pid) \
+  MAKE_CLUSTER_ADDR(HEAP_CACHEFIRSTCORE + ((Pid) % HEAP_CACHENCORES), 1)
+
+/** Precedes every block, keeps the payload 16 byte aligned */
+struct heap_hdr_s {
+  /** Payload capacity */
+  size_t size;
+  /** Size class, HEAP_CLASSES for large blocks */
+  size_t cls;
+};
+
+/** Free blocks link through their payload */
+struct heap_free_s {
+  /** Next free block, its header */
+  struct heap_hdr_s *next;
+};
+
+/** Heap of a single process */
+struct heap_s {
+  /** Next unused byte */
+  char *top;
+  /** End of the mapped range */
+  char *end;
+  /** End of the sub-space, the heap does not grow beyond */
+  char *limit;
+  /** Free small blocks per class */
+  struct heap_hdr_s *small[HEAP_CLASSES];
+  /** Free large blocks */
+  struct heap_hdr_s *large;
+};
+
+/** Free small blocks held back from the heap of a single process */
+struct heap_cache_s {
+  /** Free small blocks per class */
+  struct heap_hdr_s *small[HEAP_CLASSES];
+  /** Number of blocks per class */
+  int count[HEAP_CLASSES];
+};
+
+/** The heaps, only touched on the lock place of the pid */
+static struct heap_s heaps[MAXPROCS];
+
+/** The caches, only touched on the cache place of the pid */
+static struct heap_cache_s caches[MAXPROCS];
+
+/** \brief Takes fresh memory from the top of the heap, maps as needed.
+ * \param h The heap.
+ * \param pid Owner of new pages.
+ * \param bytes Header and payload.
+ * \return The memory, NULL if mapping failed.
+ **/
+static void *heap_bump(struct heap_s *h, int pid, size_t bytes){
+  char *res;
+  if (h->top + bytes > h->end){
+    /* Powers of two map exactly, nothing lands past the limit */
+    size_t grow = HEAP_GROW;
+    char *end;
+    while (grow < bytes) grow <<= 1;
+    if (h->end + grow > h->limit) return NULL;
+    end = reserve_range(h->end, grow, perm_read|perm_write, pid);
+    if (!end) return NULL;
+    h->end = end;
+  }
+  res = h->top;
+  h->top += bytes;
+  return res;
+}
+
+/** \brief Payload of a header.
+ * \param b The block.
+ * \return The memory handed out.
+ **/
+static void *heap_payload(struct heap_hdr_s *b){
+  return b + 1;
+}
+
+/** \brief Link of a free block.
+ * \param b The block.
+ * \return Where the next free block is kept.
+ **/
+static struct heap_hdr_s **heap_next(struct heap_hdr_s *b){
+  return &((struct heap_free_s*)heap_payload(b))->next;
+}
+
+/** \brief Rounds a request to its size class.
+ * \param size Requested bytes, receives the payload capacity for small ones.
+ * \return The class, HEAP_CLASSES for large blocks.
+ **/
+static size_t heap_class(size_t *size){
+  size_t cls = 0;
+  *size = (*size + 15) & ~(size_t)15;
+  if (!*size) *size = 16;
+  while ((cls < HEAP_CLASSES) && (((size_t)16 << cls) < *size)) cls++;
+  if (cls < HEAP_CLASSES) *size = (size_t)16 << cls;
+  return cls;
+}
+
+/* Allocation */
+sl_def(slheap_malloc_fn,, sl_glparm(int, pid), sl_glparm(size_t, size), sl_glparm(void**, res)){
+  int pid = sl_getp(pid);
+  size_t size = sl_getp(size);
+  void **res = sl_getp(res);
+  struct heap_s *h = &heaps[pid];
+  struct heap_hdr_s *b = NULL;
+  size_t cls = heap_class(&size);
+
+  if (cls < HEAP_CLASSES){
+    b = h->small[cls];
+    if (b) h->small[cls] = *heap_next(b);
+  } else {
+    /* First fit */
+    struct heap_hdr_s **pb = &h->large;
+    while (*pb && ((*pb)->size < size)){
+      pb = heap_next(*pb);
+    }
+    b = *pb;
+    if (b) *pb = *heap_next(b);
+  }
+
+  if (!b){
+    b = heap_bump(h, pid, sizeof(struct heap_hdr_s) + size);
+    if (b){
+      b->size = size;
+      b->cls = cls;
+    }
+  }
+  *res = b ? heap_payload(b) : NULL;
+}
+sl_enddef
+
+/* Release */
+sl_def(slheap_free_fn,, sl_glparm(int, pid), sl_glparm(void*, ptr)){
+  struct heap_s *h = &heaps[sl_getp(pid)];
+  struct heap_hdr_s *b = (struct heap_hdr_s*)sl_getp(ptr) - 1;
+  struct heap_hdr_s **list = (b->cls < HEAP_CLASSES) ? &h->small[b->cls] : &h->large;
+
+  *heap_next(b) = *list;
+  *list = b;
+}
+sl_enddef
+
+/* A batch of small blocks for the cache, free ones first */
+sl_def(slheap_refill_fn,, sl_glparm(int, pid), sl_glparm(size_t, cls),
+    sl_glparm(struct heap_hdr_s**, res), sl_glparm(int*, got)){
+  int pid = sl_getp(pid);
+  size_t cls = sl_getp(cls);
+  size_t size = (size_t)16 << cls;
+  struct heap_s *h = &heaps[pid];
+  struct heap_hdr_s *chain = NULL;
+  size_t carved = 0;
+  int n = 0;
+
+  while (n < HEAP_BATCH){
+    struct heap_hdr_s *b = h->small[cls];
+    if (b){
+      h->small[cls] = *heap_next(b);
+    } else {
+      if (n && (carved >= HEAP_REFILL_BYTES)) break;
+      b = heap_bump(h, pid, sizeof(struct heap_hdr_s) + size);
+      if (!b) break;
+      b->size = size;
+      b->cls = cls;
+      carved += size;
+    }
+    *heap_next(b) = chain;
+    chain = b;
+    n++;
+  }
+  *sl_getp(res) = chain;
+  *sl_getp(got) = n;
+}
+sl_enddef
+
+/* Takes back a batch the cache had too many of */
+sl_def(slheap_drain_fn,, sl_glparm(int, pid), sl_glparm(size_t, cls),
+    sl_glparm(struct heap_hdr_s*, chain)){
+  struct heap_s *h = &heaps[sl_getp(pid)];
+  size_t cls = sl_getp(cls);
+  struct heap_hdr_s *b = sl_getp(chain);
+
+  while (b){
+    struct heap_hdr_s *next = *heap_next(b);
+    *heap_next(b) = h->small[cls];
+    h->small[cls] = b;
+    b = next;
+  }
+}
+sl_enddef
+
+/* Small block from the cache of a pid */
+sl_def(slheap_cache_get_fn,, sl_glparm(int, pid), sl_glparm(size_t, cls), sl_glparm(void**, res)){
+  struct heap_cache_s *c = &caches[sl_getp(pid)];
+  size_t cls = sl_getp(cls);
+  struct heap_hdr_s *b = c->small[cls];
+
+  if (b){
+    c->small[cls] = *heap_next(b);
+    c->count[cls]--;
+  }
+  *sl_getp(res) = b ? heap_payload(b) : NULL;
+}
+sl_enddef
+
+/* Keeps n linked blocks in the cache of a pid, passes back a batch if full */
+sl_def(slheap_cache_put_fn,, sl_glparm(int, pid), sl_glparm(size_t, cls),
+    sl_glparm(struct heap_hdr_s*, chain), sl_glparm(int, n),
+    sl_glparm(struct heap_hdr_s**, spill)){
+  struct heap_cache_s *c = &caches[sl_getp(pid)];
+  size_t cls = sl_getp(cls);
+  struct heap_hdr_s *b = sl_getp(chain);
+  int n = sl_getp(n);
+
+  *sl_getp(spill) = NULL;
+  while (n-- > 0){
+    struct heap_hdr_s *next = *heap_next(b);
+    *heap_next(b) = c->small[cls];
+    c->small[cls] = b;
+    c->count[cls]++;
+    b = next;
+  }
+  if (c->count[cls] > HEAP_CACHEMAX){
+    struct heap_hdr_s **pb = &c->small[cls];
+    int i;
+    for (i=0;i<HEAP_BATCH;i++) pb = heap_next(*pb);
+    *sl_getp(spill) = c->small[cls];
+    c->small[cls] = *pb;
+    *pb = NULL;
+    c->count[cls] -= HEAP_BATCH;
+  }
+}
+sl_enddef
+
+/** \brief Hands blocks to the cache of a pid, drains any excess to its heap.
+ * \param pid The process.
+ * \param cls Class of the blocks.
+ * \param chain First of the blocks, linked through heap_next.
+ * \param n Number of blocks.
+ **/
+static void heap_cache_put(int pid, size_t cls, struct heap_hdr_s *chain, int n){
+  struct heap_hdr_s *spill = NULL;
+  sl_create(, HEAP_CACHE_PLACE(pid) ,,,,, sl__exclusive, slheap_cache_put_fn,
+      sl_glarg(int, pid, pid), sl_glarg(size_t, cls, cls),
+      sl_glarg(struct heap_hdr_s*, chain, chain), sl_glarg(int, n, n),
+      sl_glarg(struct heap_hdr_s**, spill, &spill));
+  sl_sync();
+  if (!spill) return;
+  sl_create(, HEAP_PLACE(pid) ,,,,, sl__exclusive, slheap_drain_fn,
+      sl_glarg(int, pid, pid), sl_glarg(size_t, cls, cls),
+      sl_glarg(struct heap_hdr_s*, chain, spill));
+  sl_sync();
+}
+
+void heap_reset(int pid){
+  struct heap_s *h = &heaps[pid];
+  struct admin_s *p = &proctable[pid];
+  int i;
+  h->top = (char*)p->heap_start;
+  h->end = h->top;
+  h->limit = (char*)(p->region_start + ((Elf_Addr)1 << p->region_bits));
+  for (i=0;i<HEAP_CLASSES;i++){
+    h->small[i] = NULL;
+    caches[pid].small[i] = NULL;
+    caches[pid].count[i] = 0;
+  }
+  h->large = NULL;
+}
+
+void *heap_malloc(struct loader_api_s *api, size_t size){
+  void *res = NULL;
+  int pid = api->pid;
+  size_t csize = size;
+  size_t cls = heap_class(&csize);
+
+  if (cls < HEAP_CLASSES){
+    struct heap_hdr_s *chain = NULL;
+    int got = 0;
+
+    sl_create(, HEAP_CACHE_PLACE(pid) ,,,,, sl__exclusive, slheap_cache_get_fn,
+        sl_glarg(int, pid, pid), sl_glarg(size_t, cls, cls),
+        sl_glarg(void**, res, &res));
+    sl_sync();
+    if (res) return res;
+
+    /* Cache ran dry, one trip to the heap for a batch */
+    sl_create(, HEAP_PLACE(pid) ,,,,, sl__exclusive, slheap_refill_fn,
+        sl_glarg(int, pid, pid), sl_glarg(size_t, cls, cls),
+        sl_glarg(struct heap_hdr_s**, res, &chain), sl_glarg(int*, got, &got));
+    sl_sync();
+    if (!got) return NULL;
+    if (got > 1) heap_cache_put(pid, cls, *heap_next(chain), got - 1);
+    return heap_payload(chain);
+  }
+
+  sl_create(, HEAP_PLACE(pid) ,,,,, sl__exclusive, slheap_malloc_fn,
+      sl_glarg(int, pid, pid), sl_glarg(size_t, size, size),
+      sl_glarg(void**, res, &res));
+  sl_sync();
+  return res;
+}
+
+void heap_free(struct loader_api_s *api, void *ptr){
+  int pid = api->pid;
+  struct heap_hdr_s *b;
+  if (!ptr) return;
+  /* The caller owns the block, its header is stable */
+  b = (struct heap_hdr_s*)ptr - 1;
+  if (b->cls < HEAP_CLASSES){
+    heap_cache_put(pid, b->cls, b, 1);
+    return;
+  }
+  sl_create(, HEAP_PLACE(pid) ,,,,, sl__exclusive, slheap_free_fn,
+      sl_glarg(int, pid, pid), sl_glarg(void*, ptr, ptr));
+  sl_sync();
+}
+
+void *heap_realloc(struct loader_api_s *api, void *ptr, size_t size){
+  struct heap_hdr_s *b;
+  void *res;
+
+  if (!ptr) return heap_malloc(api, size);
+  /* The caller owns the block, its header is stable */
+  b = (struct heap_hdr_s*)ptr - 1;
+  if (size <= b->size) return ptr;
+
+  res = heap_malloc(api, size);
+  if (!res) return NULL;
+  memcpy(res, ptr, b->size);
+  heap_free(api, ptr);
+  return res;
+}
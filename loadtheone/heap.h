@@ -0,0 +1,84 @@
+/**
+ * \file heap.h
+ * \author Leendert van Duijn, UvA
+ *
+ * \brief Heap for loaded programs, in pages owned by their pid.
+ *
+ * Programs reach it through their copy of the loader API, which carries
+ * their pid. Nothing is freed at exit, the pages go with the pid.
+ **/
+
+#ifndef H_HEAP
+#define H_HEAP
+
+#include <stddef.h>
+#include "loader_api.h"
+
+#ifndef HEAP_FIRSTCORE
+/** First core serializing heap operations */
+#define HEAP_FIRSTCORE 16
+#endif /* HEAP_FIRSTCORE */
+
+#ifndef HEAP_NCORES
+/** Number of heap lock cores, processes are spread over them by pid */
+#define HEAP_NCORES 8
+#endif /* HEAP_NCORES */
+
+#ifndef HEAP_CACHEFIRSTCORE
+/** First core serializing the small block caches, never a process core */
+#define HEAP_CACHEFIRSTCORE 24
+#endif /* HEAP_CACHEFIRSTCORE */
+
+#ifndef HEAP_CACHENCORES
+/** Number of cache lock cores, processes are spread over them by pid */
+#define HEAP_CACHENCORES 8
+#endif /* HEAP_CACHENCORES */
+
+#ifndef HEAP_DEFAULT
+/** Heap size planned for in the address sub-space of a process */
+#define HEAP_DEFAULT ((size_t)1 << 26)
+#endif /* HEAP_DEFAULT */
+
+#ifndef HEAP_GROW
+/** Bytes mapped at once when the heap runs out, a power of two */
+#define HEAP_GROW ((size_t)1 << 16)
+#endif /* HEAP_GROW */
+
+#ifndef HEAP_CACHEMAX
+/** Free small blocks a pid keeps per class in its cache */
+#define HEAP_CACHEMAX 32
+#endif /* HEAP_CACHEMAX */
+
+#ifndef HEAP_BATCH
+/** Blocks moved at once between that cache and the heap, at most HEAP_CACHEMAX */
+#define HEAP_BATCH 16
+#endif /* HEAP_BATCH */
+
+/**
+ * Starts an empty heap, before the program runs.
+ * \param pid The process.
+ **/
+void heap_reset(int pid);
+
+/**
+ * \param api The api of the calling process.
+ * \param size Requested bytes.
+ * \return The memory, 16 byte aligned, NULL if out of memory.
+ **/
+void *heap_malloc(struct loader_api_s *api, size_t size);
+
+/**
+ * \param api The api of the calling process.
+ * \param ptr Memory from heap_malloc or heap_realloc, NULL is ignored.
+ **/
+void heap_free(struct loader_api_s *api, void *ptr);
+
+/**
+ * \param api The api of the calling process.
+ * \param ptr Memory to resize, NULL allocates.
+ * \param size Requested bytes.
+ * \return The memory, possibly moved, NULL if out of memory.
+ **/
+void *heap_realloc(struct loader_api_s *api, void *ptr, size_t size);
+
+#endif /* H_HEAP */
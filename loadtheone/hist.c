@@ -0,0 +1,91 @@
+/**
+ * \file hist.c
+ * \brief File housing the loader latency histograms.
+ *  Leendert van Duijn
+ *  UvA
+ *
+ *  Values go into power of two buckets, so quantiles are exact to within a
+ *  factor two, which is enough to spot a regression. The maximum is kept
+ *  exactly.
+ *
+ **/
+
+#include <stdio.h>
+
+#include <svp/mgsim.h>
+#include <svp/abort.h>
+
+#include "ELF.h"
+#include "loader.h"
+#include "hist.h"
+
+/** A single histogram */
+struct hist_s {
+  /** Values counted */
+  unsigned long count;
+  /** Largest value counted */
+  unsigned long max;
+  /** Values per bucket */
+  unsigned long bucket[HIST_BUCKETS];
+};
+
+/** The histograms, by e_hist */
+static struct hist_s hists[hist_count];
+
+/** Names used in the summary, by e_hist */
+static const char *histnames[hist_count] = {
+  "TicksToDetach",
+  "DetachToEnd",
+  "EndToCleaned",
+  "MemWait",
+  "PrintWait"
+};
+
+void hist_add(int h, unsigned long ticks){
+  struct hist_s *hs = &hists[h];
+  int b = 0;
+  while ((b < HIST_BUCKETS - 1) && (ticks >> b)) b++;
+  hs->bucket[b]++;
+  hs->count++;
+  if (ticks > hs->max) hs->max = ticks;
+}
+
+unsigned long hist_counted(int h){
+  return hists[h].count;
+}
+
+unsigned long hist_quantile(int h, int permille){
+  struct hist_s *hs = &hists[h];
+  unsigned long want;
+  unsigned long seen = 0;
+  int b;
+
+  if (!hs->count) return 0;
+  want = (hs->count * permille + 999) / 1000;
+  if (!want) want = 1;
+  for (b=0;b<HIST_BUCKETS - 1;b++){
+    seen += hs->bucket[b];
+    if (seen >= want) break;
+  }
+  if (b == HIST_BUCKETS - 1) return hs->max;
+  /* Bucket b holds values below 2^b, never beyond the largest seen */
+  if (((1ul << b) - 1) > hs->max) return hs->max;
+  return (1ul << b) - 1;
+}
+
+void hist_summary(void){
+  char buff[1024];
+  int h;
+
+  for (h=0;h<hist_count;h++){
+    if (!hists[h].count) continue;
+    snprintf(buff, 1023, "<Hist>%s,%lu,%lu,%lu,%lu,%lu</Hist>\n",
+        histnames[h],
+        hists[h].count,
+        hist_quantile(h, 500),
+        hist_quantile(h, 900),
+        hist_quantile(h, 990),
+        hists[h].max);
+    locked_print_string(buff, PRINTERR);
+  }
+}
@@ -0,0 +1,64 @@
+/**
+ * \file hist.h
+ * \author Leendert van Duijn, UvA
+ *
+ * \brief Log2 bucketed latency histograms, kept by the loader itself.
+ *
+ * There is no lock of their own, each histogram is only updated on the
+ * place that already serializes the event it measures.
+ **/
+
+#ifndef H_HIST
+#define H_HIST
+
+#ifndef HIST_BUCKETS
+/** Buckets per histogram, bucket b > 0 holds values in [2^(b-1), 2^b) */
+#define HIST_BUCKETS 40
+#endif /* HIST_BUCKETS */
+
+/**
+ * The histograms, each with the place it is updated on.
+ **/
+enum e_hist {
+  /**Create to detach, on the pid lock*/
+  hist_detach = 0,
+  /**Detach to end, on the pid lock*/
+  hist_run,
+  /**End to cleaned, on the pid lock*/
+  hist_clean,
+  /**Wait for MEMCORE, on MEMCORE*/
+  hist_memwait,
+  /**Wait for PRINTCORE, on PRINTCORE*/
+  hist_printwait,
+  /**Number of histograms*/
+  hist_count
+};
+
+/**
+ * Counts a value, only from the place owning the histogram.
+ * \param h The e_hist.
+ * \param ticks The value.
+ **/
+void hist_add(int h, unsigned long ticks);
+
+/**
+ * \param h The e_hist.
+ * \return Values counted.
+ **/
+unsigned long hist_counted(int h);
+
+/**
+ * \param h The e_hist.
+ * \param permille Quantile, 500 for the median.
+ * \return Upper bound of the bucket holding the quantile, 0 when empty.
+ **/
+unsigned long hist_quantile(int h, int permille);
+
+/**
+ * Prints count, p50, p90, p99 and max of every histogram holding values,
+ * as <Hist> lines.
+ * Read unlocked, while processes run the counts can be a few events behind.
+ **/
+void hist_summary(void);
+
+#endif /* H_HIST */
@@ -0,0 +1,265 @@
+/**
+ * \file intern.c
+ * \brief File housing the shared argument blocks.
+ *  Leendert van Duijn
+ *  UvA
+ *
+ *  Argument vectors and environments are hashed, equal ones share a single
+ *  block in the loader's own sub-space (pid 0), below where heaps live. Blocks
+ *  are reference counted per process and recycled once unused.
+ *  The table is administrated on the pid allocation node, references are
+ *  dropped there when the pid is freed.
+ *
+ **/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <svp/mgsim.h>
+#include <svp/abort.h>
+
+#include "ELF.h"
+#include "basfunc.h"
+#include "loader.h"
+#include "intern.h"
+#include "lockstat.h"
+
+/** Which node is used for PID/base allocation/determination */
+#define NODE_BASELOCK 3
+
+/** Where the blocks live, above anything loaded for pid 0 */
+#define INTERN_BASE (base_off + base_progmaxsize / 4)
+
+/** What a block holds */
+enum e_internkind {
+  intern_args_k = 1,
+  intern_env_k
+};
+
+/** A shared block */
+struct intern_s {
+  /** Content hash */
+  unsigned long hash;
+  /** Bytes in use */
+  size_t size;
+  /** Entries, argc for argument vectors */
+  int count;
+  /** e_internkind, 0 when empty */
+  int kind;
+  /** Processes using the block */
+  int refs;
+  /** 1 once filled, -1 if filling failed */
+  volatile int ready;
+  /** Set once the pages of the slot are mapped */
+  int mapped;
+  /** Age for picking a slot to recycle */
+  unsigned long lastuse;
+};
+
+/** The blocks */
+static struct intern_s blocks[INTERN_SLOTS];
+
+/** Lookup counter, ages the blocks */
+static unsigned long interntick = 0;
+
+/** \brief FNV-1a step.
+ * \param h Running hash.
+ * \param s Bytes to add.
+ * \param n Number of bytes.
+ * \return The updated hash.
+ **/
+static unsigned long hash_bytes(unsigned long h, const char *s, size_t n){
+  size_t i;
+  for (i=0;i<n;i++){
+    h ^= (unsigned char)s[i];
+    h *= 1099511628211ul;
+  }
+  return h;
+}
+
+/* Finds a block by hash, or claims one to fill */
+sl_def(slintern_get_fn,, sl_glparm(unsigned long, hash), sl_glparm(size_t, size),
+    sl_glparm(int, count), sl_glparm(int, kind), sl_glparm(int*, ref), sl_glparm(int*, fill),
+    sl_glparm(clock_t, t0)){
+  unsigned long hash = sl_getp(hash);
+  size_t size = sl_getp(size);
+  int count = sl_getp(count);
+  int kind = sl_getp(kind);
+  int *ref = sl_getp(ref);
+  int *fill = sl_getp(fill);
+  int i;
+  int victim = -1;
+  LOCK_ENTER(lock_pid, sl_getp(t0));
+
+  *ref = 0;
+  *fill = 0;
+  interntick++;
+  for (i=0;i<INTERN_SLOTS;i++){
+    struct intern_s *b = &blocks[i];
+    if ((b->kind == kind) && (b->hash == hash) && (b->size == size) &&
+        (b->count == count) && (b->ready >= 0)){
+      b->refs++;
+      b->lastuse = interntick;
+      *ref = i + 1;
+      LOCK_LEAVE(lock_pid);
+      return;
+    }
+    if ((b->refs == 0) &&
+        ((victim == -1) || (b->lastuse < blocks[victim].lastuse))){
+      victim = i;
+    }
+  }
+
+  if (victim != -1){
+    struct intern_s *b = &blocks[victim];
+    b->kind = kind;
+    b->hash = hash;
+    b->size = size;
+    b->count = count;
+    b->refs = 1;
+    b->ready = 0;
+    b->lastuse = interntick;
+    *ref = victim + 1;
+    *fill = 1;
+  }
+  LOCK_LEAVE(lock_pid);
+}
+sl_enddef
+
+/* Drops a reference from outside the lock */
+sl_def(slintern_release_fn,, sl_glparm(int, ref), sl_glparm(clock_t, t0)){
+  LOCK_ENTER(lock_pid, sl_getp(t0));
+  intern_release(sl_getp(ref));
+  LOCK_LEAVE(lock_pid);
+}
+sl_enddef
+
+void intern_release(int ref){
+  if ((ref > 0) && (ref <= INTERN_SLOTS)) blocks[ref - 1].refs--;
+}
+
+/** \brief Drops a reference taken by intern_get.
+ * \param ref The reference, cleared.
+ **/
+static void intern_put(int *ref){
+  sl_create(, MAKE_CLUSTER_ADDR(NODE_BASELOCK, 1) ,,,,, sl__exclusive, slintern_release_fn,
+      sl_glarg(int, ref, *ref), sl_glarg(clock_t, t0, LOCK_REQUEST()));
+  sl_sync();
+  *ref = 0;
+}
+
+/** \brief Takes a reference on a block of content hash.
+ * \param hash Content hash.
+ * \param size Bytes of the layout.
+ * \param count Entries of the layout, argc for argument vectors.
+ * \param kind e_internkind.
+ * \param ref Receives the reference.
+ * \param fill Set when the caller must lay out the content.
+ * \return Address of the block, NULL if none is available.
+ **/
+static char *intern_get(unsigned long hash, size_t size, int count, int kind,
+                        int *ref, int *fill){
+  struct intern_s *b;
+  char *addr;
+
+  if (size > INTERN_BLOCKMAX) return NULL;
+  sl_create(, MAKE_CLUSTER_ADDR(NODE_BASELOCK, 1) ,,,,, sl__exclusive, slintern_get_fn,
+      sl_glarg(unsigned long, hash, hash), sl_glarg(size_t, size, size),
+      sl_glarg(int, count, count), sl_glarg(int, kind, kind), sl_glarg(int*, ref, ref),
+      sl_glarg(int*, fill, fill), sl_glarg(clock_t, t0, LOCK_REQUEST()));
+  sl_sync();
+  if (!*ref) return NULL;
+
+  b = &blocks[*ref - 1];
+  addr = (char*)(INTERN_BASE + (Elf_Addr)(*ref - 1) * INTERN_BLOCKMAX);
+  if (*fill){
+    if (!b->mapped){
+      if (!reserve_range(addr, INTERN_BLOCKMAX, perm_read|perm_write, 0)){
+        b->ready = -1;
+        intern_put(ref);
+        return NULL;
+      }
+      b->mapped = 1;
+    }
+    return addr;
+  }
+
+  /* Still being filled by whoever claimed it, copy privately instead of waiting */
+  if (b->ready <= 0){
+    intern_put(ref);
+    return NULL;
+  }
+  return addr;
+}
+
+char **intern_args(int argc, char **argv, int *ref){
+  unsigned long hash = 14695981039346656037ul;
+  size_t size = sizeof(char*) * (argc + 1);
+  int fill = 0;
+  char **sv;
+  int i;
+
+  hash = hash_bytes(hash, (const char*)&argc, sizeof(argc));
+  for (i=0;i<argc;i++){
+    size_t len = argv[i] ? strlen(argv[i]) : 0;
+    hash = hash_bytes(hash, argv[i] ? argv[i] : "", len + 1);
+    size += len + 1;
+  }
+
+  sv = (char**)intern_get(hash, size, argc, intern_args_k, ref, &fill);
+  if (!sv) return NULL;
+
+  if (fill){
+    char *cpnt = (char*)(sv + argc + 1);
+    for (i=0;i<argc;i++){
+      size_t len = argv[i] ? strlen(argv[i]) : 0;
+      memcpy(cpnt, argv[i], len);
+      cpnt[len] = 0;
+      sv[i] = cpnt;
+      cpnt += len + 1;
+    }
+    sv[argc] = NULL;
+    blocks[*ref - 1].ready = 1;
+    return sv;
+  }
+
+  /* Hashes may collide, and a block may have been written to */
+  if (sv[argc]){
+    intern_put(ref);
+    return NULL;
+  }
+  for (i=0;i<argc;i++){
+    if ((sv[i] < (char*)(sv + argc + 1)) || (sv[i] >= (char*)sv + size) ||
+        strcmp(sv[i], argv[i] ? argv[i] : "")){
+      intern_put(ref);
+      return NULL;
+    }
+  }
+  return sv;
+}
+
+char *intern_env(char *envp, int *ref){
+  unsigned long hash = 14695981039346656037ul;
+  size_t size = 0;
+  int fill = 0;
+  char *se;
+
+  while (envp[size] || envp[size+1]) size++;
+  size += 2;
+  hash = hash_bytes(hash, envp, size);
+
+  se = intern_get(hash, size, 0, intern_env_k, ref, &fill);
+  if (!se) return NULL;
+
+  if (fill){
+    memcpy(se, envp, size);
+    blocks[*ref - 1].ready = 1;
+    return se;
+  }
+
+  if (memcmp(se, envp, size)){
+    intern_put(ref);
+    return NULL;
+  }
+  return se;
+}
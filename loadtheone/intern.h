@@ -0,0 +1,51 @@
+/**
+ * \file intern.h
+ * \author Leendert van Duijn, UvA
+ *
+ * \brief Shared argv and environment blocks, interned by content.
+ *
+ * Bulk launches hand every child the same arguments and environment, those
+ * are laid out once in the loader's own sub-space and shared by reference.
+ * The blocks are not protected, so sharing is only done for processes
+ * started with e_sharedargs.
+ **/
+
+#ifndef H_INTERN
+#define H_INTERN
+
+#include "loader_api.h"
+
+#ifndef INTERN_SLOTS
+/** Number of blocks kept */
+#define INTERN_SLOTS 32
+#endif /* INTERN_SLOTS */
+
+#ifndef INTERN_BLOCKMAX
+/** Largest block interned, larger ones are copied per process */
+#define INTERN_BLOCKMAX ((size_t)1 << 16)
+#endif /* INTERN_BLOCKMAX */
+
+/**
+ * Finds or creates the shared copy of an argument vector.
+ * \param argc As requested.
+ * \param argv As requested.
+ * \param ref Receives the reference to drop with intern_release.
+ * \return The shared vector, NULL if it could not be shared.
+ **/
+char **intern_args(int argc, char **argv, int *ref);
+
+/**
+ * Finds or creates the shared copy of an environment block.
+ * \param envp As requested, double nullbyte terminated.
+ * \param ref Receives the reference to drop with intern_release.
+ * \return The shared block, NULL if it could not be shared.
+ **/
+char *intern_env(char *envp, int *ref);
+
+/**
+ * Drops a reference, call on the pid allocation node only.
+ * \param ref The reference, 0 is ignored.
+ **/
+void intern_release(int ref);
+
+#endif /* H_INTERN */
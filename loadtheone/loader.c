@@ -24,6 +24,14 @@
 #include "loader.h"
 #include "basfunc.h"
 #include "extrafuns.h"
+#include "loadq.h"
+#include "pool.h"
+#include "arena.h"
+#include "heap.h"
+#include "trace.h"
+#include "hist.h"
+#include "lockstat.h"
+#include "stats.h"
 
 /** \brief Parses key value pairs.
  * \param key The named value.
@@ -44,6 +52,12 @@ int parse_setting(const char* key, const char* val,
     *settings |= e_noprogname;
     return 0;
   }
+  if (streq(key, "core_start") &&
+      streq(val, "any")){
+    /** core_start with any, leaves placement to the loader */
+    out->core_start = -1;
+    return 0;
+  }
   if (streq(key, "core_start")){
     /** core_start with number, sets core_start */
     out->core_start = strtoul(val, NULL, 0);
@@ -77,6 +91,29 @@ int parse_setting(const char* key, const char* val,
     *settings |= e_timeit;
     return 0;
   }
+  if (streq(key, "pool")){
+    /** pool with number, keeps that many instances warm instead of running */
+    out->pool = strtol(val, NULL, 0);
+    return 0;
+  }
+  if (streq(key, "trace")){
+    /** trace with a filename, timing goes to the binary ring dumped there */
+    free(trace_path);
+    trace_path = strdup(val);
+    return 0;
+  }
+  if (streq(key, "color") &&
+      streq(val, "true")){
+    /** color with true, staggers process bases over the memory banks */
+    base_coloring = 1;
+    return 0;
+  }
+  if (streq(key, "sharedargs") &&
+      streq(val, "true")){
+    /** sharedargs with true, sets the e_sharedargs flag */
+    *settings |= e_sharedargs;
+    return 0;
+  }
   if (streq(key, "exclusive") &&
       streq(val, "true")){
     /** exclusive with true, sets the e_exclusive flag*/
@@ -158,36 +195,34 @@ int read_settings(int fd, struct admin_s *out){
  * Reads environment block.
  * \param fd Open file to read from.
  * \param out The administration to load to.
+ * \param a Arena holding the block.
  * \return 0 on success.
- *
- * TODO might need looking at malloc
  **/
-int read_env(int fd, struct admin_s *out){
+int read_env(int fd, struct admin_s *out, struct arena_s *a){
   int i = 0;
   int esc = 0;
   char b = 1;
-  off_t osta = 0;
-  off_t oend = 0;
+  size_t room = 256;
 
-  /**Get needed space, might be more than needed, but its enough.
-  newlines get turned into null's
+  /**The block grows as needed, newlines get turned into null's
   comments take no room
   escaped chars take half their file space in memory
-  this might be way too much space
   */
-
-  // osta = lseek(fd, 0, SEEK_CUR);
-  //oend = lseek(fd, 0, SEEK_END);
-  //lseek(fd, osta, SEEK_SET);
-  osta = 0;
-
-  /** At the time of writing seek lacked implementation, TODO */
-  oend = 1024*1024;
-  out->envp = malloc(2 + (oend - osta));
+  out->envp = arena_alloc(a, room);
+  if (!out->envp) return -1;
 
   while (b){
     if (! read(fd, &b, 1)) break;
 
+    if ((size_t)i + 3 > room){
+      /* Old block stays in the arena, released with it */
+      char *grown = arena_alloc(a, room * 2);
+      if (!grown) return -1;
+      memcpy(grown, out->envp, room);
+      out->envp = grown;
+      room *= 2;
+    }
+
     //Initialize on the go
     out->envp[i] = b;
     out->envp[i+1] = 0;
@@ -231,7 +266,6 @@ int read_env(int fd, struct admin_s *out){
 
   if (out->envp[0] == 0){
     //No env
-    free(out->envp);
     out->envp = NULL;
   }
 
@@ -242,15 +276,18 @@ int read_env(int fd, struct admin_s *out){
 /** \brief Reads arguments.
  * \param fd File to read from
  * \param out Administration to load to.
+ * \param a Arena holding the vector and strings.
  * \return 0 on success
  **/
-int read_argv(int fd, struct admin_s *out){
+int read_argv(int fd, struct admin_s *out, struct arena_s *a){
   char buff[2048];
   int i = 0;
   int esc = 0;
   char b = 1;
+  int room = 16;
 
-  out->argv = malloc(sizeof(char*)*2);
+  out->argv = arena_alloc(a, sizeof(char*) * room);
+  if (!out->argv) return -1;
   out->argv[0] = out->fname;
   out->argc = 1;
 
@@ -293,9 +330,16 @@ int read_argv(int fd, struct admin_s *out){
           break;
         }
         //append
-        out->argv[out->argc] = strdup(buff);
+        if (out->argc + 2 > room){
+          char **grown = arena_alloc(a, sizeof(char*) * room * 2);
+          if (!grown) return -1;
+          memcpy(grown, out->argv, sizeof(char*) * room);
+          out->argv = grown;
+          room *= 2;
+        }
+        out->argv[out->argc] = arena_strdup(a, buff);
+        if (!out->argv[out->argc]) return -1;
         out->argc++;
-        out->argv = realloc(out->argv, (1 + out->argc) * sizeof(char*));
         out->argv[out->argc] = NULL;
         i = 0;
         continue;
@@ -308,7 +352,6 @@ int read_argv(int fd, struct admin_s *out){
   //entry)
   if (out->argc == 1){
     if (out->argv[0] == NULL){
-      free(out->argv);
       out->argv = NULL;
       out->argc= 0;
     }
@@ -322,6 +365,7 @@ int read_argv(int fd, struct admin_s *out){
 void elf_fromconf(int fd){
   //Called for reading config
   struct admin_s params;
+  struct arena_s scratch;
   ZERO_ADMINP(&params);
   params.core_start = 0;
   params.core_size = 1;
@@ -329,7 +373,19 @@ void elf_fromconf(int fd){
   params.verbose = VERB_TRACE+1;
   params.settings = 0;
   read_settings(fd, &params);
-  read_argv(fd, &params);
+  arena_open(&scratch, 0);
+  if (read_argv(fd, &params, &scratch)){
+
+#if ENABLE_DEBUG
+    if (params.verbose > VERB_ERR){
+      locked_print_string("Problems reading args from config\n", PRINTERR);
+    }
+#endif /* ENABLE_DEBUG */
+
+    arena_close(&scratch);
+    free(params.fname);
+    return;
+  }
   if (!params.fname) {
 
 #if ENABLE_DEBUG
@@ -339,9 +395,10 @@ void elf_fromconf(int fd){
     }
 #endif /* ENABLE_DEBUG */
 
+    arena_close(&scratch);
     return;
   }
-  if (read_env(fd, &params)){
+  if (read_env(fd, &params, &scratch)){
 
 #if ENABLE_DEBUG
     if (params.verbose > VERB_ERR){
@@ -349,16 +406,18 @@ void elf_fromconf(int fd){
     }
 #endif /* ENABLE_DEBUG */
 
+    arena_close(&scratch);
+    free(params.fname);
     return;
   }
 
-  int i = 0;
-  elf_loadfile_p(&params, params.settings);
-  for (i=0;i < params.argc;i++) {
-    free(params.argv[i]);
+  if (params.pool > 0){
+    pool_prime(params.fname, params.pool);
+  } else {
+    elf_loadfile_p(&params, params.settings);
   }
-  free(params.argv);
-  free(params.envp);
+  arena_close(&scratch);
+  free(params.fname);
 }
 
 /** \brief Loads from config file, filename.
@@ -404,6 +463,22 @@ struct loader_api_s loader_api = {
   &elf_fromconfname,
   &elf_fromconf,
   &elf_loadfile_p,
-  &elf_clientbreakpoint
+  &elf_clientbreakpoint,
+  &elf_loadtree_p,
+  &elf_wait,
+  &elf_wait_many,
+  &cq_init,
+  &cq_drain,
+  &loadq_enqueue,
+  &pool_prime,
+  &heap_malloc,
+  &heap_free,
+  &heap_realloc,
+  &trace_dump,
+  &hist_summary,
+  &lock_stats,
+  &loader_stats,
+  &proc_snapshot,
+  0
 };
 
@@ -33,6 +33,16 @@
 #define ENABLE_CLOCKCALLS 1
 #endif
 
+#ifndef ENABLE_PERFCOUNTERS
+/** On true samples the core performance counters around each program */
+#define ENABLE_PERFCOUNTERS 1
+#endif
+
+#ifndef MAXPROCS
+/** How much Process table entries to statically allocate */
+#define MAXPROCS 1024
+#endif /* MAXPROCS */
+
 /** Main function type, loaded programs 'entry' point*/
 typedef int (main_function_t)(int argc, char **argv, char *envp, void* spwn);
 
@@ -43,6 +53,12 @@ void init_admins(void);
 
 int function_spawn(main_function_t * main_f,
                     struct admin_s *);
+int function_join(int pid);
+
+void cq_init(struct loader_cq_s *cq);
+void cq_push(struct loader_cq_s *cq, struct admin_s *p);
+int cq_drain(struct loader_cq_s *cq, struct loader_completion_s *out,
+             int max, enum e_waitflags flags);
 
 int elf_loadprogram(char*, size_t, int verbose,
                     enum e_settings,
@@ -54,15 +70,48 @@ int elf_loadprogram_p(char*, size_t,
     );
 
 
-int elf_loadfile(const char *fname, enum e_settings flags,
+loader_handle_t elf_loadfile(const char *fname, enum e_settings flags,
               int argc, char **argv, char* env);
 void elf_fromconfname(const char *fn);
 void elf_fromconf(int fd);
 
-int elf_loadfile_p(struct admin_s *, enum e_settings);
+loader_handle_t elf_loadfile_p(struct admin_s *, enum e_settings);
+int elf_loadtree_p(struct admin_s *list, int count, int fanout,
+                   enum e_settings flags, loader_levelcb_t *levelcb);
+
+int elf_wait(loader_handle_t h, int *exit_code, enum e_waitflags flags);
+int elf_wait_many(loader_handle_t *hs, int count, int *exit_codes,
+                  enum e_waitflags flags);
+
+int elf_launch_p(struct admin_s *p, struct admin_s *params,
+                 enum e_settings flags);
+
+int proc_snapshot(struct loader_procinfo_s *out, int max);
+
+/** Keeps the compiler from moving memory accesses across it */
+#define PROC_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+/**
+ * Opens a change of the process table entry P, as seen by proc_snapshot.
+ * Only the current owner of the entry writes, so no lock is taken.
+ **/
+#define PROC_WRITE_BEGIN(P) do { (P)->seq++; PROC_BARRIER(); } while (0)
+
+/** Closes a change opened by PROC_WRITE_BEGIN */
+#define PROC_WRITE_END(P) do { PROC_BARRIER(); (P)->seq++; } while (0)
+
+/** Pids handed out and not pooled, only touched on the pid lock */
+extern int activeprocs;
+
+/** Base coloring policy, on true process bases are staggered per color */
+extern int base_coloring;
+
+/** The process table, indexed by pid */
+extern struct admin_s proctable[MAXPROCS];
 
+void place_process(struct admin_s *p, const struct admin_s *req);
 void locked_delbase(int deadpid);
-Elf_Addr locked_newbase(struct admin_s **params);
+Elf_Addr locked_newbase(struct admin_s **params, struct admin_s *req, int bits);
 
 #endif
 
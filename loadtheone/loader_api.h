@@ -7,6 +7,7 @@
 
 #ifndef H_LOADAPI_A
 #define H_LOADAPI_A
+#include <string.h>
 #include <time.h>
 
 /** Makes a numerical parameter for core placement */
@@ -28,7 +29,7 @@
 #endif /* base_off */
 
 #ifndef base_progmaxsize
-/** The size of an address sub-space **/
+/** The size of the loader's own address sub-space, see region.h **/
 #define base_progmaxsize (Elf_Addr)(1l << 50)
 #endif /* base_progmaxsize */
 
@@ -47,11 +48,259 @@
  * \param e_timeit On (true && ENABLE_DEBUG && ENABLE_CLOCKCALLS) prints timing
  * information on proccess termination.
  * \param e_exclusive On true requests the MGSim for sl_exclusive on sl_create.
+ * \param e_joinable On true the process is not detached, its pid and exit code
+ * are kept until it is reaped through wait or wait_many.
+ * \param e_topool Internal, loads an instance into the warm pool instead of
+ * running it.
+ * \param e_sharedargs On true argv and env may be shared with other processes
+ * started with equal ones, the process must not write to them. Otherwise they
+ * are copied for the process alone.
  **/
 enum e_settings {
   e_noprogname = 1,
   e_timeit = 1 << 2,
-  e_exclusive = 1 << 3
+  e_exclusive = 1 << 3,
+  e_joinable = 1 << 4,
+  e_topool = 1 << 5,
+  e_sharedargs = 1 << 6
+};
+
+/**
+ * \param e_wait_nohang Return instead of blocking on a running process.
+ **/
+enum e_waitflags {
+  e_wait_nohang = 1
+};
+
+/**
+ * Life cycle of a process table entry.
+ **/
+enum e_procstate {
+  /**Entry is on the freelist*/
+  proc_free = 0,
+  /**Pid allocated, image being loaded*/
+  proc_loading,
+  /**Control transferred*/
+  proc_running,
+  /**Terminated, waiting to be reaped (e_joinable only)*/
+  proc_zombie,
+  /**Loaded and relocated, waiting in the warm pool*/
+  proc_pooled
+};
+
+/**
+ * Phases of a load, admin_s.phaseticks holds the ticks spent in each.
+ * \param ph_open File opened and statted.
+ * \param ph_read File read into scratch memory.
+ * \param ph_check Headers marshalled and checked.
+ * \param ph_pid Pid and address sub-space allocation.
+ * \param ph_reserve Page reservation, including the wait for MEMCORE.
+ * \param ph_copy Segment copy and clearing.
+ * \param ph_scan Section scan for symbols and rooms.
+ * \param ph_reloc Relocation.
+ * \param ph_args Argument and environment marshalling.
+ * \param ph_count Number of phases.
+ **/
+enum e_phase {
+  ph_open = 0,
+  ph_read,
+  ph_check,
+  ph_pid,
+  ph_reserve,
+  ph_copy,
+  ph_scan,
+  ph_reloc,
+  ph_args,
+  ph_count
+};
+
+/**
+ * Core performance counters, admin_s.perfdelta holds their change over the
+ * main function, as seen on the first core of the place.
+ * \param pf_cycles Core cycles.
+ * \param pf_insns Instructions executed.
+ * \param pf_loads Loads completed.
+ * \param pf_stores Stores completed.
+ * \param pf_lines Cache lines loaded into the L1, its misses.
+ * \param pf_count Number of counters.
+ **/
+enum e_perf {
+  pf_cycles = 0,
+  pf_insns,
+  pf_loads,
+  pf_stores,
+  pf_lines,
+  pf_count
+};
+
+/**
+ * Exclusive service places, for lock_stats.
+ **/
+enum e_lock {
+  /**Pid allocation and release, NODE_BASELOCK*/
+  lock_pid = 0,
+  /**Page maps, MEMCORE*/
+  lock_mem,
+  /**Output, PRINTCORE*/
+  lock_print,
+  /**Number of locks*/
+  lock_count
+};
+
+/**
+ * Contention counters of an exclusive place, ticks summed over requests.
+ **/
+struct loader_lockstat_s {
+  /** Families run on the place */
+  unsigned long requests;
+  /** From request to the family starting */
+  unsigned long waitticks;
+  /** From the family starting to it ending */
+  unsigned long holdticks;
+  /** Longest single wait */
+  unsigned long maxwait;
+};
+
+/** Relocation types counted apart in loader_stats_s.relocs, the last one
+ * counts all others */
+#define STATS_RELOCTYPES 4
+
+/**
+ * Loader statistics, every counter only ever grows except pids_inuse and
+ * bytes_mapped.
+ **/
+struct loader_stats_s {
+  /** Loads that got a pid */
+  unsigned long loads_started;
+  /** Loads that failed, with or without a pid */
+  unsigned long loads_failed;
+  /** Bytes of ELF images loaded from */
+  unsigned long bytes_read;
+  /** Bytes copied into segments */
+  unsigned long bytes_copied;
+  /** Bytes cleared, in segments and in kept pages */
+  unsigned long bytes_zeroed;
+  /** Pages mapped */
+  unsigned long pages_mapped;
+  /** Pages unmapped */
+  unsigned long pages_unmapped;
+  /** Bytes asked of reserve_range */
+  unsigned long bytes_requested;
+  /** Bytes of the pages handed out for those, the rest is rounding */
+  unsigned long bytes_reserved;
+  /** Bytes mapped now, pages kept for reuse included */
+  unsigned long bytes_mapped;
+  /** Most bytes ever mapped at once */
+  unsigned long bytes_mapped_highwater;
+  /** Relocations applied: GLOB_DAT, RELATIVE, JMP_SLOT, other */
+  unsigned long relocs[STATS_RELOCTYPES];
+  /** Symbols scanned */
+  unsigned long symbols;
+  /** Print requests */
+  unsigned long prints;
+  /** Bytes printed by string prints */
+  unsigned long bytes_printed;
+  /** Pids handed out now, pooled ones included */
+  unsigned long pids_inuse;
+  /** Most pids ever handed out at once, pooled ones included */
+  unsigned long pids_highwater;
+};
+
+/** Page size classes, class c holds pages of 4096 << c bytes */
+#define LOADER_PAGECLASSES 8
+
+/** Bytes of the file name kept in loader_procinfo_s, terminator included */
+#define LOADER_PROCNAME 64
+
+/**
+ * A process as seen by proc_snapshot, copied from a consistent state.
+ **/
+struct loader_procinfo_s {
+  /** The pid */
+  int pid;
+  /** Generation of the pid, as in its handle */
+  int generation;
+  /** e_procstate */
+  int state;
+  /** First core, -1 while pooled */
+  int core_start;
+  /** Number of cores */
+  int core_size;
+  /** Base address of the image */
+  unsigned long base;
+  /** Start of the heap */
+  unsigned long heap_start;
+  /** File name, truncated to fit */
+  char fname[LOADER_PROCNAME];
+  /** As in admin_s, 0 if not timed */
+  clock_t createtick;
+  /** As in admin_s, 0 if not timed or not yet detached */
+  clock_t detachtick;
+  /** As in admin_s, 0 if not timed or still running */
+  clock_t lasttick;
+  /** Pages in use by the process */
+  unsigned long pages;
+  /** Pages in use by size class */
+  unsigned long pageclass[LOADER_PAGECLASSES];
+  /** Bytes asked of reserve_range */
+  unsigned long bytes_requested;
+  /** Bytes of the pages in use */
+  unsigned long bytes_reserved;
+};
+
+/** Process handle, a pid combined with the generation of its table entry */
+typedef long loader_handle_t;
+
+/** Makes a handle from a pid and generation */
+#define LOADER_HANDLE(Pid, Gen) ((((loader_handle_t)(Gen)) << 16) | (Pid))
+
+/** The pid part of a handle */
+#define HANDLE_PID(H) ((int)((H) & 0xffff))
+
+/** The generation part of a handle */
+#define HANDLE_GEN(H) ((int)((H) >> 16))
+
+#ifndef CQ_SIZE
+/** Number of records a completion queue holds */
+#define CQ_SIZE 256
+#endif /* CQ_SIZE */
+
+/**
+ * Record of a terminated process, as found on a completion queue.
+ **/
+struct loader_completion_s {
+  /** The pid of the terminated process */
+  int pidnum;
+  /** The generation of the pid, together forming its handle */
+  int generation;
+  /** Return value of the main function */
+  int exit_code;
+  /** As the admin_s fields */
+  clock_t createtick;
+  /** As the admin_s fields */
+  clock_t detachtick;
+  /** As the admin_s fields */
+  clock_t lasttick;
+  /** As the admin_s fields */
+  clock_t cleaneduptick;
+};
+
+/**
+ * Completion queue, owned and drained by a single parent, pushed onto by any
+ * number of terminating children.
+ * Initialize with cq_init before passing it in admin_s.cq.
+ **/
+struct loader_cq_s {
+  /** Records pushed so far, a record is complete before this is advanced */
+  volatile unsigned long head;
+  /** Records drained so far, only advanced by the owner */
+  volatile unsigned long tail;
+  /** Records lost because the queue was full */
+  volatile unsigned long dropped;
+  /** Lost records already reported by cq_drain, only advanced by the owner */
+  unsigned long reported;
+  /** Storage, indexed modulo CQ_SIZE */
+  struct loader_completion_s ring[CQ_SIZE];
 };
 
 /**
@@ -60,19 +309,45 @@ enum e_settings {
 struct admin_s {
   /** The pid for this entry */
   int pidnum;
+  /** Incremented each time the pid is allocated, guards against pid reuse */
+  int generation;
+  /** e_procstate of this entry */
+  int state;
+  /** Return value of the main function, once terminated */
+  int exit_code;
   /** Numerical setting for verbosity */
   int verbose;
   /** e_settings for settings */
   unsigned long settings;
   /** The base address for this process */
   unsigned long base;
+  /** Entry point, relocated, set once loaded */
+  unsigned long entry;
+  /** End of the last page mapped for the image, set once loaded */
+  unsigned long image_end;
+  /** Start of the address sub-space of the process */
+  unsigned long region_start;
+  /** Size of the sub-space as address bits, 0 if none is held */
+  int region_bits;
+  /** Start of the heap, the heap ends with the sub-space */
+  unsigned long heap_start;
+  /** Heap bytes wanted, 0 for the default */
+  unsigned long heap_size;
   /** The filename for the ELF file */
   char *fname;
+  /** Copy of fname the loader keeps for the life of the pid, fname points here */
+  char procname[LOADER_PROCNAME];
 
-  /** The starting core to load to, or -1 */
+  /** The starting core to load to, or -1 for any, picked by the loader */
   int core_start;
   /** The number of allotted cores, or -1 */
   int core_size;
+  /** If set with core_start -1, the cores any may pick from */
+  int *affinity;
+  /** Number of entries in affinity */
+  int affinity_count;
+  /** If set with core_start -1, pid of a process not to share cores with */
+  int antiaffinity;
   /** Passed argc */
   int argc;
   /** Passed argv */
@@ -92,17 +367,51 @@ struct admin_s {
   /** If set, just before the PID is freed to the loader and printing of times */
   clock_t cleaneduptick;
 
+  /** If set, ticks spent per load phase, together within TicksToDetach */
+  clock_t phaseticks[ph_count];
+
+  /** If set, counter change over the main function, by e_perf */
+  long perfdelta[pf_count];
+
   /** Function pointer to be called on timing event. */
   void (*timecallback)(void);
 
-  /** Symbol information */
+  /** Depth in the launch tree this process was started at, 0 for direct */
+  int launchlevel;
+
+  /** If set, receives a record when this process terminates */
+  struct loader_cq_s *cq;
+
+  /** Loading from config only, keep this many warm instances, do not run */
+  int pool;
+
+  /** Scratch arena cache the load uses, set by loader workers, 0 for none */
+  int arenaslot;
+
+  /** Symbol information, or a room mapped by the loader */
   unsigned long argroom_offset;
-  /** Symbol information */
+  /** Symbol information, or a room mapped by the loader */
   unsigned long argroom_size;
-  /** Symbol information */
+  /** Symbol information, or a room mapped by the loader */
   unsigned long envroom_offset;
-  /** Symbol information */
+  /** Symbol information, or a room mapped by the loader */
   unsigned long envroom_size;
+  /** Bytes of argv and env marshalled into the rooms */
+  unsigned long argbytes;
+  /** Reference on the shared argv block, 0 if private */
+  int argshare;
+  /** Reference on the shared env block, 0 if private */
+  int envshare;
+
+  /** Pages reserved since the pid was handed out, by size class */
+  unsigned long pageclass[LOADER_PAGECLASSES];
+  /** Bytes asked of reserve_range since the pid was handed out */
+  unsigned long bytes_requested;
+  /** Bytes of the pages reserved for those, at least bytes_requested */
+  unsigned long bytes_reserved;
+
+  /** Even while the entry is stable, odd while a writer changes it */
+  unsigned int seq;
 
   /** Freelist 'pointer' */
   int nextfreepid;
@@ -115,21 +424,48 @@ struct admin_s {
   (X)->timecallback = 0;\
   (X)->settings = 0;\
   (X)->pidnum = 0;\
+  (X)->generation = 0;\
+  (X)->state = proc_free;\
+  (X)->exit_code = 0;\
   (X)->verbose = 0;\
   (X)->base = 0;\
+  (X)->entry = 0;\
+  (X)->image_end = 0;\
+  (X)->region_start = 0;\
+  (X)->region_bits = 0;\
+  (X)->heap_start = 0;\
+  (X)->heap_size = 0;\
   (X)->fname = 0;\
+  (X)->procname[0] = 0;\
   (X)->core_start = 0;\
   (X)->core_size = 0;\
+  (X)->affinity = 0;\
+  (X)->affinity_count = 0;\
+  (X)->antiaffinity = 0;\
   (X)->argc = 0;\
   (X)->argv = 0;\
   (X)->envp = 0;\
   (X)->createtick = 0;\
   (X)->detachtick = 0;\
+  (X)->lasttick = 0;\
   (X)->cleaneduptick = 0;\
+  memset((X)->phaseticks, 0, sizeof((X)->phaseticks));\
+  memset((X)->perfdelta, 0, sizeof((X)->perfdelta));\
+  (X)->launchlevel = 0;\
+  (X)->cq = 0;\
+  (X)->pool = 0;\
+  (X)->arenaslot = 0;\
   (X)->argroom_offset = 0;\
   (X)->argroom_size = 0;\
   (X)->envroom_offset = 0;\
   (X)->envroom_size = 0;\
+  (X)->argbytes = 0;\
+  (X)->argshare = 0;\
+  (X)->envshare = 0;\
+  memset((X)->pageclass, 0, sizeof((X)->pageclass));\
+  (X)->bytes_requested = 0;\
+  (X)->bytes_reserved = 0;\
+  (X)->seq = 0;\
   (X)->nextfreepid = 0;
 
 /**
@@ -145,12 +481,21 @@ enum handled_by {
 };
 
 
+/**
+ * Called by each node of a tree launch, as it starts its part of the list.
+ * Nodes run concurrently, keep what is noted per entry.
+ * \param entry The list entry the node loads, the first of its part.
+ * \param level Depth in the launch tree, 0 for the root.
+ * \param tick The clock() value at which the node started.
+ **/
+typedef void (loader_levelcb_t)(struct admin_s *entry, int level, clock_t tick);
+
 /**
  *Structure passed as API
  * */
 struct loader_api_s {
-  /**Spawns a program from file, with parameters.**/
-  int (*spawn)(const char *programma,
+  /**Spawns a program from file, with parameters, returns a handle.**/
+  loader_handle_t (*spawn)(const char *programma,
                enum e_settings,
                int argc, char **argv,
                char *env);
@@ -165,10 +510,50 @@ struct loader_api_s {
   void (*load_fromconf)(const char* fname);
   /**Loads from opened config file*/
   void (*load_fromconf_fd)(int fd);
-  /**Loads from preconfigured structure*/
-  int (*load_fromparam)(struct admin_s *, enum e_settings);
+  /**Loads from preconfigured structure, returns a handle*/
+  loader_handle_t (*load_fromparam)(struct admin_s *, enum e_settings);
   /**Calls a system breakpoint*/
   enum handled_by (*breakpoint)(int id, const char *msg);
+  /**Loads a list of preconfigured structures as a tree, fanout wide,
+   * returns the number of entries that failed to load, -1 on bad arguments*/
+  int (*load_tree)(struct admin_s *list, int count, int fanout,
+                   enum e_settings, loader_levelcb_t *levelcb);
+  /**Waits for an e_joinable process, 0 when reaped, 1 if running and nohang*/
+  int (*wait)(loader_handle_t, int *exit_code, enum e_waitflags);
+  /**Waits for many e_joinable processes, returns the number reaped*/
+  int (*wait_many)(loader_handle_t *, int count, int *exit_codes,
+                   enum e_waitflags);
+  /**Prepares an empty completion queue*/
+  void (*cq_init)(struct loader_cq_s *);
+  /**Takes up to max records, in order of termination, returns the number.
+   * Waiting is bounded and may return 0, retry when records are expected.
+   * Records lost to a full queue are reported once as minus their number,
+   * ahead of records still queued, each stands for a terminated child*/
+  int (*cq_drain)(struct loader_cq_s *, struct loader_completion_s *out,
+                  int max, enum e_waitflags);
+  /**Queues a load from preconfigured structure, returns once queued,
+   * -1 for e_joinable or cq requests, as no handle is returned*/
+  int (*load_async)(struct admin_s *, enum e_settings);
+  /**Keeps count instances of an image loaded, spawns of it take one*/
+  int (*pool_prime)(const char *fname, int count);
+  /**Allocates from the heap of the process owning this api*/
+  void *(*malloc)(struct loader_api_s *, size_t);
+  /**Returns memory to the heap of the process owning this api*/
+  void (*free)(struct loader_api_s *, void *);
+  /**Resizes memory from the heap of the process owning this api*/
+  void *(*realloc)(struct loader_api_s *, void *, size_t);
+  /**Writes the binary trace ring to its file now, -1 if tracing is off*/
+  int (*trace_dump)(void);
+  /**Prints p50/p90/p99/max of the loader latency histograms*/
+  void (*timing_summary)(void);
+  /**Copies the contention counters of an e_lock, -1 on an unknown lock*/
+  int (*lock_stats)(int lock, struct loader_lockstat_s *out);
+  /**Fills in the loader statistics, summed over all counters*/
+  void (*stats)(struct loader_stats_s *out);
+  /**Copies up to max live processes into out, returns the number copied*/
+  int (*proc_snapshot)(struct loader_procinfo_s *out, int max);
+  /**Pid of the process this copy was handed to*/
+  int pid;
 };
 
 
@@ -0,0 +1,274 @@
+/**
+ * \file loadq.c
+ * \brief File housing the launch queues.
+ *  Leendert van Duijn
+ *  UvA
+ *
+ *  Callers only enqueue a copy of their request. Each loader core has a
+ *  deque and, while there is work, a worker family loading from it. A worker
+ *  which runs dry steals from the other queues before it retires.
+ *
+ *  Every deque is guarded by its own core, operations on it are exclusive
+ *  families there, so contention is per queue instead of system wide.
+ *
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <svp/mgsim.h>
+#include <svp/abort.h>
+
+#include "ELF.h"
+#include "loader.h"
+#include "loadq.h"
+#include "pool.h"
+#include "sched.h"
+
+/** A queued request */
+struct loadq_item_s {
+  /** Copy of the request */
+  struct admin_s params;
+  /** Flags of the request */
+  unsigned long flags;
+  /** Holds the copied strings and tables, freed after loading */
+  char *block;
+};
+
+/** A launch deque */
+struct loadq_s {
+  /** Storage, indexed modulo LOADQ_DEPTH */
+  struct loadq_item_s items[LOADQ_DEPTH];
+  /** Oldest entry, thieves take from here */
+  volatile unsigned long top;
+  /** One past the newest entry, the owner takes from here */
+  volatile unsigned long bottom;
+  /** True while a worker serves this queue */
+  int active;
+};
+
+/** One deque per loader core */
+static struct loadq_s loadqs[LOADQ_NCORES];
+
+/**
+ * Spreads requests without placement over the queues. Bumped by any caller
+ * outside a lock, a lost update only skews the spread, which is accepted.
+ **/
+static unsigned int loadq_next = 0;
+
+/* Push, the result is -1 when full, 1 when a worker needs starting, else 0 */
+sl_def(slloadq_push_fn,, sl_glparm(struct loadq_item_s*, item), sl_glparm(int, q), sl_glparm(int*, res)){
+  struct loadq_s *lq = &loadqs[sl_getp(q)];
+  int *res = sl_getp(res);
+
+  if (lq->bottom - lq->top >= LOADQ_DEPTH){
+    *res = -1;
+  } else {
+    lq->items[lq->bottom % LOADQ_DEPTH] = *sl_getp(item);
+    lq->bottom++;
+    *res = (lq->active)?0:1;
+    lq->active = 1;
+  }
+}
+sl_enddef
+
+/* Owner pop of the newest entry, an empty queue retires the worker if asked */
+sl_def(slloadq_pop_fn,, sl_glparm(struct loadq_item_s*, item), sl_glparm(int, q), sl_glparm(int, retire), sl_glparm(int*, res)){
+  struct loadq_s *lq = &loadqs[sl_getp(q)];
+  int *res = sl_getp(res);
+
+  if (lq->bottom == lq->top){
+    if (sl_getp(retire)) lq->active = 0;
+    *res = 0;
+  } else {
+    lq->bottom--;
+    *sl_getp(item) = lq->items[lq->bottom % LOADQ_DEPTH];
+    *res = 1;
+  }
+}
+sl_enddef
+
+/* Thief pop of the oldest entry */
+sl_def(slloadq_steal_fn,, sl_glparm(struct loadq_item_s*, item), sl_glparm(int, q), sl_glparm(int*, res)){
+  struct loadq_s *lq = &loadqs[sl_getp(q)];
+  int *res = sl_getp(res);
+
+  if (lq->bottom == lq->top){
+    *res = 0;
+  } else {
+    *sl_getp(item) = lq->items[lq->top % LOADQ_DEPTH];
+    lq->top++;
+    *res = 1;
+  }
+}
+sl_enddef
+
+/** \brief Takes work for the worker of queue q, its own first.
+ * \param q The queue of the worker.
+ * \param item Receives the work.
+ * \param retire On true an empty system retires the worker.
+ * \return 1 if item was filled.
+ **/
+static int loadq_take(int q, struct loadq_item_s *item, int retire){
+  int res = 0;
+  int i;
+
+  sl_create(, MAKE_CLUSTER_ADDR(LOADQ_FIRSTCORE + q, 1) ,,,,, sl__exclusive, slloadq_pop_fn,
+      sl_glarg(struct loadq_item_s*, item, item), sl_glarg(int, q, q),
+      sl_glarg(int, retire, 0), sl_glarg(int*, res, &res));
+  sl_sync();
+  if (res) return 1;
+
+  for (i=1;i<LOADQ_NCORES;i++){
+    int v = (q + i) % LOADQ_NCORES;
+    /* Unlocked peek, only pay for the trip to a queue with work */
+    if (loadqs[v].bottom == loadqs[v].top) continue;
+    sl_create(, MAKE_CLUSTER_ADDR(LOADQ_FIRSTCORE + v, 1) ,,,,, sl__exclusive, slloadq_steal_fn,
+        sl_glarg(struct loadq_item_s*, item, item), sl_glarg(int, q, v),
+        sl_glarg(int*, res, &res));
+    sl_sync();
+    if (res) return 1;
+  }
+
+  if (!retire) return 0;
+
+  /* Pushes racing the retirement are seen here, or start a new worker */
+  sl_create(, MAKE_CLUSTER_ADDR(LOADQ_FIRSTCORE + q, 1) ,,,,, sl__exclusive, slloadq_pop_fn,
+      sl_glarg(struct loadq_item_s*, item, item), sl_glarg(int, q, q),
+      sl_glarg(int, retire, 1), sl_glarg(int*, res, &res));
+  sl_sync();
+  return res;
+}
+
+/** \brief Loads a request, a failed pool refill is reported to the pool.
+ * \param item The request.
+ **/
+static void loadq_load(struct loadq_item_s *item){
+  if (!elf_loadfile_p(&item->params, item->flags) &&
+      ((item->params.settings | item->flags) & e_topool)){
+    pool_refill_failed(item->params.fname);
+  }
+  free(item->block);
+}
+
+/* Worker, loads until its own and all other queues are empty */
+sl_def(slloadq_worker_fn,, sl_glparm(int, q)){
+  int q = sl_getp(q);
+  struct loadq_item_s item;
+
+  while (loadq_take(q, &item, 1)){
+    /* One worker per queue, its arena cache is its own */
+    item.params.arenaslot = q + 1;
+    loadq_load(&item);
+  }
+}
+sl_enddef
+
+/** \brief Size of an environment block, including the double null.
+ * \param env The block.
+ * \return Size in bytes, 0 for no block.
+ **/
+static size_t envsize(const char *env){
+  size_t i = 0;
+  if (!env) return 0;
+  while (env[i] || env[i+1]) i++;
+  return i + 2;
+}
+
+/** \brief Copies everything a request points to into one block.
+ * \param item The item to fill, params already copied.
+ * \return 0 on success.
+ **/
+static int loadq_copyrequest(struct loadq_item_s *item){
+  struct admin_s *p = &item->params;
+  size_t need = 0;
+  size_t esize = envsize(p->envp);
+  size_t fsize = (p->fname)?(strlen(p->fname) + 1):0;
+  char *cpnt;
+  int i;
+
+  need += sizeof(char*) * (p->argc + 1);
+  need += sizeof(int) * p->affinity_count;
+  for (i=0;p->argv && (i<p->argc);i++){
+    need += (p->argv[i])?(strlen(p->argv[i]) + 1):1;
+  }
+  need += esize + fsize;
+
+  item->block = malloc(need);
+  if (!item->block) return -1;
+
+  /* Pointer sized data first, keeping it aligned */
+  cpnt = item->block;
+  if (p->argv){
+    char **av = (char**)cpnt;
+    cpnt += sizeof(char*) * (p->argc + 1);
+    for (i=0;i<p->argc;i++){
+      size_t l = (p->argv[i])?strlen(p->argv[i]):0;
+      av[i] = cpnt;
+      if (l) memcpy(cpnt, p->argv[i], l);
+      cpnt[l] = 0;
+      cpnt += l + 1;
+    }
+    av[p->argc] = NULL;
+    p->argv = av;
+  } else {
+    cpnt += sizeof(char*) * (p->argc + 1);
+  }
+  if (p->affinity && p->affinity_count){
+    memcpy(cpnt, p->affinity, sizeof(int) * p->affinity_count);
+    p->affinity = (int*)cpnt;
+    cpnt += sizeof(int) * p->affinity_count;
+  }
+  if (esize){
+    memcpy(cpnt, p->envp, esize);
+    p->envp = cpnt;
+    cpnt += esize;
+  }
+  if (fsize){
+    memcpy(cpnt, p->fname, fsize);
+    p->fname = cpnt;
+  }
+  return 0;
+}
+
+int loadq_enqueue(struct admin_s *params, enum e_settings flags){
+  struct loadq_item_s item;
+  int q;
+  int res = 0;
+
+  /* Nobody could ever wait for these, their pids would never be reaped */
+  if (((params->settings | flags) & e_joinable) || params->cq) return -1;
+
+  item.params = *params;
+  item.params.arenaslot = 0;
+  item.flags = flags;
+  if (loadq_copyrequest(&item)) return -1;
+
+  /* Scheduled cores map to queues by range, so neighbours share a queue */
+  if ((params->core_start >= SCHED_FIRSTCORE) &&
+      (params->core_start < SCHED_FIRSTCORE + SCHED_NCORES)){
+    q = (params->core_start - SCHED_FIRSTCORE) * LOADQ_NCORES / SCHED_NCORES;
+  } else if (params->core_start >= 0){
+    /* Outside the scheduled range, only spread */
+    q = params->core_start % LOADQ_NCORES;
+  } else {
+    q = (loadq_next++) % LOADQ_NCORES;
+  }
+
+  sl_create(, MAKE_CLUSTER_ADDR(LOADQ_FIRSTCORE + q, 1) ,,,,, sl__exclusive, slloadq_push_fn,
+      sl_glarg(struct loadq_item_s*, item, &item), sl_glarg(int, q, q),
+      sl_glarg(int*, res, &res));
+  sl_sync();
+
+  if (res == -1){
+    /* Every worker is busy enough, load here */
+    loadq_load(&item);
+    return 0;
+  }
+  if (res == 1){
+    sl_create(, MAKE_CLUSTER_ADDR(LOADQ_FIRSTCORE + q, 1) ,,,,, , slloadq_worker_fn,
+        sl_glarg(int, q, q));
+    sl_detach();
+  }
+  return 0;
+}
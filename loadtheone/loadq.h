@@ -0,0 +1,41 @@
+/**
+ * \file loadq.h
+ * \author Leendert van Duijn, UvA
+ *
+ * \brief Launch queues, loading requests on a set of loader cores.
+ *
+ **/
+
+#ifndef H_LOADQ
+#define H_LOADQ
+
+#include "loader_api.h"
+
+#ifndef LOADQ_FIRSTCORE
+/** First core running a loader worker */
+#define LOADQ_FIRSTCORE 8
+#endif /* LOADQ_FIRSTCORE */
+
+#ifndef LOADQ_NCORES
+/** Number of loader cores, each with its own queue and worker */
+#define LOADQ_NCORES 4
+#endif /* LOADQ_NCORES */
+
+#ifndef LOADQ_DEPTH
+/** Requests a single queue holds before callers load themselves */
+#define LOADQ_DEPTH 64
+#endif /* LOADQ_DEPTH */
+
+/**
+ * Queues a load on one of the loader cores, returning before it is loaded.
+ * fname, argv, env and affinity are copied, the caller may reuse them.
+ * No handle is returned, so e_joinable requests, which only a waiter can
+ * reap, and requests with a cq are refused; load those with load_fromparam.
+ * \param params The prepared settings, core_start picks the queue if set.
+ * \param flags Any flags required.
+ * \return 0 once queued or, with all queues full, loaded; -1 on failure or
+ * for a refused request.
+ **/
+int loadq_enqueue(struct admin_s *params, enum e_settings flags);
+
+#endif /* H_LOADQ */
@@ -0,0 +1,78 @@
+/**
+ * \file lockstat.c
+ * \brief File housing the exclusive place contention counters.
+ *  Leendert van Duijn
+ *  UvA
+ *
+ *  The pid lock and MEMCORE are the same core, they are counted apart to
+ *  tell which kind of request queues, their sum is what the core carries.
+ *
+ **/
+
+#include <stdio.h>
+
+#include <svp/mgsim.h>
+#include <svp/abort.h>
+
+#include "ELF.h"
+#include "loader.h"
+#include "hist.h"
+#include "lockstat.h"
+#include "trace.h"
+
+/** The counters, by e_lock */
+static struct loader_lockstat_s lockstats[lock_count];
+
+/** Names used in the summary, by e_lock */
+static const char *locknames[lock_count] = {
+  "Pid",
+  "Mem",
+  "Print"
+};
+
+/** Histogram the wait also goes into, by e_lock, -1 for none */
+static const int lockhists[lock_count] = {
+  -1,
+  hist_memwait,
+  hist_printwait
+};
+
+clock_t lock_enter(int lock, clock_t t0){
+  clock_t now = clock();
+  struct loader_lockstat_s *ls = &lockstats[lock];
+  unsigned long wait = now - t0;
+
+  ls->requests++;
+  ls->waitticks += wait;
+  if (wait > ls->maxwait) ls->maxwait = wait;
+  if (lockhists[lock] >= 0) hist_add(lockhists[lock], wait);
+  return now;
+}
+
+void lock_leave(int lock, clock_t t0, clock_t entry){
+  unsigned long hold = clock() - entry;
+  lockstats[lock].holdticks += hold;
+  if (trace_path) trace_lock(lock, entry, entry - t0, hold);
+}
+
+int lock_stats(int lock, struct loader_lockstat_s *out){
+  if ((lock < 0) || (lock >= lock_count)) return -1;
+  *out = lockstats[lock];
+  return 0;
+}
+
+void lock_summary(void){
+  char buff[1024];
+  int l;
+
+  for (l=0;l<lock_count;l++){
+    if (!lockstats[l].requests) continue;
+    snprintf(buff, 1023, "<Lock>%s,%lu,%lu,%lu,%lu</Lock>\n",
+        locknames[l],
+        lockstats[l].requests,
+        lockstats[l].waitticks,
+        lockstats[l].holdticks,
+        lockstats[l].maxwait);
+    locked_print_string(buff, PRINTERR);
+  }
+}
@@ -0,0 +1,61 @@
+/**
+ * \file lockstat.h
+ * \author Leendert van Duijn, UvA
+ *
+ * \brief Contention counters for the exclusive service places.
+ *
+ * Every family on such a place takes the tick of its request, counts its
+ * wait on entry and its hold time on leaving. The counters are only
+ * written on the place itself, so they need no lock of their own.
+ **/
+
+#ifndef H_LOCKSTAT
+#define H_LOCKSTAT
+
+#include <time.h>
+#include "loader_api.h"
+
+#if ENABLE_CLOCKCALLS
+/** Tick passed along with a request, as the t0 argument */
+#define LOCK_REQUEST() clock()
+/** Starts the family body on lock L, declares the request and entry ticks */
+#define LOCK_ENTER(L, T0) clock_t lockt0_ = (T0), lockentry_ = lock_enter((L), lockt0_)
+/** Ends the family body on lock L, before every return */
+#define LOCK_LEAVE(L) lock_leave((L), lockt0_, lockentry_)
+#else
+#define LOCK_REQUEST() 0
+#define LOCK_ENTER(L, T0)
+#define LOCK_LEAVE(L) do {} while (0)
+#endif /* ENABLE_CLOCKCALLS */
+
+/**
+ * Counts a request and its wait, on the place of the lock only.
+ * \param lock The e_lock.
+ * \param t0 Tick of the request.
+ * \return Tick of entry.
+ **/
+clock_t lock_enter(int lock, clock_t t0);
+
+/**
+ * Counts the hold time, on the place of the lock only.
+ * With tracing on the request goes to the trace as well.
+ * \param lock The e_lock.
+ * \param t0 Tick of the request.
+ * \param entry Tick from lock_enter.
+ **/
+void lock_leave(int lock, clock_t t0, clock_t entry);
+
+/**
+ * Copies the counters of a lock, read unlocked.
+ * \param lock The e_lock.
+ * \param out Receives the counters.
+ * \return 0 on success, -1 on an unknown lock.
+ **/
+int lock_stats(int lock, struct loader_lockstat_s *out);
+
+/**
+ * Prints the counters of every lock used, as <Lock> lines.
+ **/
+void lock_summary(void);
+
+#endif /* H_LOCKSTAT */
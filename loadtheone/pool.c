@@ -0,0 +1,228 @@
+/**
+ * \file pool.c
+ * \brief File housing the warm pool.
+ *  Leendert van Duijn
+ *  UvA
+ *
+ *  Keeps instances of selected images loaded and relocated in their own pid,
+ *  so a spawn only needs to store arguments and create the family.
+ *  The pool is administrated on the pid allocation node, like the process
+ *  table its entries live in.
+ *
+ **/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <svp/mgsim.h>
+#include <svp/abort.h>
+
+#include "ELF.h"
+#include "basfunc.h"
+#include "loader.h"
+#include "loadq.h"
+#include "sched.h"
+#include "pool.h"
+#include "heap.h"
+#include "lockstat.h"
+
+/** Which node is used for PID/base allocation/determination */
+#define NODE_BASELOCK 3
+
+/** Instances of a single image */
+struct pool_s {
+  /** The image */
+  char fname[POOL_NAMELEN];
+  /** Instances to keep */
+  int want;
+  /** Instances being loaded */
+  int refilling;
+  /** Instances ready */
+  int count;
+  /** Pids of the ready instances */
+  int pids[POOL_MAX];
+};
+
+/** The pooled images */
+static struct pool_s pools[POOL_IMAGES];
+
+/** Number of pooled images, never decreases */
+static volatile int npools = 0;
+
+/** \brief Finds the pool of an image, call on NODE_BASELOCK only.
+ * \param fname The image.
+ * \return The pool or NULL.
+ **/
+static struct pool_s *pool_find(const char *fname){
+  int i;
+  if (!fname) return NULL;
+  for (i=0;i<npools;i++){
+    if (streq(pools[i].fname, fname)) return &pools[i];
+  }
+  return NULL;
+}
+
+/** \brief Notes how many instances need loading, call on NODE_BASELOCK only.
+ * \param pl The pool.
+ * \return Number of refills the caller must start.
+ **/
+static int pool_shortage(struct pool_s *pl){
+  int n = pl->want - pl->count - pl->refilling;
+  if (n < 0) n = 0;
+  pl->refilling += n;
+  return n;
+}
+
+/** \brief Tells if the instances of a pool can serve a request.
+ * Instances are loaded with the default heap, settings are all applied at
+ * launch, so only the heap size of the request needs to agree.
+ * \param req The request.
+ * \return True if a pooled instance fits.
+ **/
+static int pool_fits(const struct admin_s *req){
+  return (!req->heap_size) || (req->heap_size == HEAP_DEFAULT);
+}
+
+/* Registers an image */
+sl_def(slpool_prime_fn,, sl_glparm(const char*, fname), sl_glparm(int, count), sl_glparm(int*, res),
+    sl_glparm(clock_t, t0)){
+  const char *fname = sl_getp(fname);
+  int *res = sl_getp(res);
+  int count = sl_getp(count);
+  LOCK_ENTER(lock_pid, sl_getp(t0));
+  struct pool_s *pl = pool_find(fname);
+
+  if (count > POOL_MAX) count = POOL_MAX;
+  if ((!pl) && (npools < POOL_IMAGES) && (strlen(fname) < POOL_NAMELEN)){
+    pl = &pools[npools];
+    strcpy(pl->fname, fname);
+    pl->want = 0;
+    pl->refilling = 0;
+    pl->count = 0;
+    npools++;
+  }
+  if (pl){
+    pl->want = count;
+    *res = pool_shortage(pl);
+  } else {
+    *res = -1;
+  }
+  LOCK_LEAVE(lock_pid);
+}
+sl_enddef
+
+/* Takes an instance, places it for the request */
+sl_def(slpool_take_fn,, sl_glparm(struct admin_s*, req), sl_glparm(struct admin_s**, out), sl_glparm(int*, refills),
+    sl_glparm(clock_t, t0)){
+  struct admin_s *req = sl_getp(req);
+  struct admin_s **out = sl_getp(out);
+  LOCK_ENTER(lock_pid, sl_getp(t0));
+  struct pool_s *pl = pool_find(req->fname);
+
+  *out = NULL;
+  *sl_getp(refills) = 0;
+  if (pl && pl->count && pool_fits(req)){
+    pl->count--;
+    *out = &proctable[pl->pids[pl->count]];
+    PROC_WRITE_BEGIN(*out);
+    (*out)->state = proc_loading;
+    activeprocs++;
+    place_process(*out, req);
+    PROC_WRITE_END(*out);
+    *sl_getp(refills) = pool_shortage(pl);
+  }
+  LOCK_LEAVE(lock_pid);
+}
+sl_enddef
+
+/* Keeps an instance, if its image still wants one */
+sl_def(slpool_put_fn,, sl_glparm(struct admin_s*, p), sl_glparm(int*, res), sl_glparm(clock_t, t0)){
+  struct admin_s *p = sl_getp(p);
+  int *res = sl_getp(res);
+  LOCK_ENTER(lock_pid, sl_getp(t0));
+  struct pool_s *pl = pool_find(p->fname);
+
+  *res = -1;
+  if (pl){
+    pl->refilling--;
+    if (pl->count < pl->want){
+      /* Not running, so not counted as load on its core */
+      sched_occupy(p->core_start, p->core_size, -1);
+      PROC_WRITE_BEGIN(p);
+      p->core_start = -1;
+      p->state = proc_pooled;
+      PROC_WRITE_END(p);
+      activeprocs--;
+      pl->pids[pl->count++] = p->pidnum;
+      *res = 0;
+    }
+  }
+  LOCK_LEAVE(lock_pid);
+}
+sl_enddef
+
+/* Counts a refill that did not reach the pool */
+sl_def(slpool_fail_fn,, sl_glparm(const char*, fname), sl_glparm(clock_t, t0)){
+  LOCK_ENTER(lock_pid, sl_getp(t0));
+  struct pool_s *pl = pool_find(sl_getp(fname));
+  if (pl && (pl->refilling > 0)) pl->refilling--;
+  LOCK_LEAVE(lock_pid);
+}
+sl_enddef
+
+void pool_refill_failed(const char *fname){
+  sl_create(, MAKE_CLUSTER_ADDR(NODE_BASELOCK, 1) ,,,,, sl__exclusive, slpool_fail_fn,
+      sl_glarg(const char*, fname, fname), sl_glarg(clock_t, t0, LOCK_REQUEST()));
+  sl_sync();
+}
+
+/** \brief Queues background loads for the pool.
+ * \param fname The image.
+ * \param n Number of instances.
+ **/
+static void pool_refill(const char *fname, int n){
+  struct admin_s params;
+  while (n-- > 0){
+    ZERO_ADMINP(&params);
+    params.fname = (char*)fname;
+    params.settings = e_topool;
+    params.core_start = -1;
+    params.core_size = 1;
+    /* Not queued, so it would never report back */
+    if (loadq_enqueue(&params, e_topool)) pool_refill_failed(fname);
+  }
+}
+
+int pool_prime(const char *fname, int count){
+  int res = 0;
+  sl_create(, MAKE_CLUSTER_ADDR(NODE_BASELOCK, 1) ,,,,, sl__exclusive, slpool_prime_fn,
+      sl_glarg(const char*, fname, fname), sl_glarg(int, count, count),
+      sl_glarg(int*, res, &res), sl_glarg(clock_t, t0, LOCK_REQUEST()));
+  sl_sync();
+  if (res < 0) return -1;
+  pool_refill(fname, res);
+  return 0;
+}
+
+struct admin_s *pool_take(struct admin_s *req){
+  struct admin_s *p = NULL;
+  int refills = 0;
+
+  /* Unlocked peek, no trip to the lock without any pooled image */
+  if (!npools) return NULL;
+
+  sl_create(, MAKE_CLUSTER_ADDR(NODE_BASELOCK, 1) ,,,,, sl__exclusive, slpool_take_fn,
+      sl_glarg(struct admin_s*, req, req), sl_glarg(struct admin_s**, out, &p),
+      sl_glarg(int*, refills, &refills), sl_glarg(clock_t, t0, LOCK_REQUEST()));
+  sl_sync();
+  if (p) pool_refill(req->fname, refills);
+  return p;
+}
+
+int pool_put(struct admin_s *p){
+  int res = -1;
+  sl_create(, MAKE_CLUSTER_ADDR(NODE_BASELOCK, 1) ,,,,, sl__exclusive, slpool_put_fn,
+      sl_glarg(struct admin_s*, p, p), sl_glarg(int*, res, &res), sl_glarg(clock_t, t0, LOCK_REQUEST()));
+  sl_sync();
+  return res;
+}
@@ -0,0 +1,57 @@
+/**
+ * \file pool.h
+ * \author Leendert van Duijn, UvA
+ *
+ * \brief Warm pool, processes loaded and relocated ahead of their spawn.
+ *
+ **/
+
+#ifndef H_POOL
+#define H_POOL
+
+#include "loader_api.h"
+
+#ifndef POOL_IMAGES
+/** Number of distinct images the pool keeps instances of */
+#define POOL_IMAGES 8
+#endif /* POOL_IMAGES */
+
+#ifndef POOL_MAX
+/** Maximum number of instances kept per image */
+#define POOL_MAX 32
+#endif /* POOL_MAX */
+
+#ifndef POOL_NAMELEN
+/** Maximum filename length of a pooled image, as kept per process */
+#define POOL_NAMELEN LOADER_PROCNAME
+#endif /* POOL_NAMELEN */
+
+/**
+ * Keeps count instances of an image loaded, refilled in the background.
+ * \param fname The ELF file.
+ * \param count Instances to keep, 0 stops refilling.
+ * \return 0 on success, -1 if the pool has no room for another image.
+ **/
+int pool_prime(const char *fname, int count);
+
+/**
+ * Takes a pooled instance for a request, placed as requested.
+ * \param req The request, matched on fname and heap_size.
+ * \return The instance, or NULL if none is ready.
+ **/
+struct admin_s *pool_take(struct admin_s *req);
+
+/**
+ * Offers a freshly prepared instance to the pool.
+ * \param p The instance, loaded with e_topool.
+ * \return 0 if kept, -1 if not wanted, the caller then frees it.
+ **/
+int pool_put(struct admin_s *p);
+
+/**
+ * Reports a refill load that failed, so the pool starts another one later.
+ * \param fname The image.
+ **/
+void pool_refill_failed(const char *fname);
+
+#endif /* H_POOL */
@@ -0,0 +1,131 @@
+/**
+ * \file region.c
+ * \brief File housing the address sub-space allocator.
+ *  Leendert van Duijn
+ *  UvA
+ *
+ *  A buddy allocator over [REGION_BASE, REGION_BASE + 2^REGION_TOPBITS).
+ *  Free sub-spaces are kept per size in lists of nodes from a fixed pool,
+ *  the managed memory itself is never touched, it is not mapped.
+ *  Freshly split halves are taken first, so processes started one after
+ *  the other end up close together.
+ *
+ **/
+
+#include "ELF.h"
+#include "loader.h"
+#include "region.h"
+
+/** A free sub-space */
+struct region_node_s {
+  /** Start address */
+  unsigned long start;
+  /** Next free sub-space of the same size, or next unused node */
+  struct region_node_s *next;
+};
+
+/** Node pool */
+static struct region_node_s regionnodes[REGION_NODES];
+
+/** Unused nodes */
+static struct region_node_s *regionspare = NULL;
+
+/** Number of unused nodes */
+static int regionspares = 0;
+
+/** Free sub-spaces per size, index 0 is REGION_MINBITS */
+static struct region_node_s *regionfree[REGION_ORDERS];
+
+/** Set once the whole range is on the free lists */
+static int regioninit = 0;
+
+/** \brief Puts the whole range on the free lists. **/
+static void region_setup(void){
+  int i;
+  for (i=0;i<REGION_NODES;i++){
+    regionnodes[i].next = regionspare;
+    regionspare = &regionnodes[i];
+  }
+  regionspares = REGION_NODES - 1;
+  regionfree[REGION_ORDERS - 1] = regionspare;
+  regionspare = regionspare->next;
+  regionfree[REGION_ORDERS - 1]->start = REGION_BASE;
+  regionfree[REGION_ORDERS - 1]->next = NULL;
+  regioninit = 1;
+}
+
+/** \brief Adds a free sub-space.
+ * \param o Size index.
+ * \param start Start address.
+ * \return 0 on success, -1 without spare nodes.
+ **/
+static int region_push(int o, unsigned long start){
+  struct region_node_s *n = regionspare;
+  if (!n) return -1;
+  regionspare = n->next;
+  regionspares--;
+  n->start = start;
+  n->next = regionfree[o];
+  regionfree[o] = n;
+  return 0;
+}
+
+int region_bits(unsigned long bytes){
+  int bits = REGION_MINBITS;
+  while ((bits < REGION_TOPBITS) && (((unsigned long)1 << bits) < bytes)) bits++;
+  return bits;
+}
+
+int region_alloc(int bits, unsigned long *start){
+  int o = bits - REGION_MINBITS;
+  int j;
+  struct region_node_s *n;
+
+  if (!regioninit) region_setup();
+  if ((o < 0) || (o >= REGION_ORDERS)) return -1;
+
+  for (j=o;(j<REGION_ORDERS) && !regionfree[j];j++);
+  if (j == REGION_ORDERS) return -1;
+  /* Every upper half needs a node, nothing is taken unless all fit */
+  if (regionspares + 1 < j - o) return -1;
+
+  n = regionfree[j];
+  regionfree[j] = n->next;
+  *start = n->start;
+  n->next = regionspare;
+  regionspare = n;
+  regionspares++;
+
+  /* Split down, the upper halves stay free */
+  while (j > o){
+    j--;
+    region_push(j, *start + ((unsigned long)1 << (j + REGION_MINBITS)));
+  }
+  return 0;
+}
+
+void region_free(unsigned long start, int bits){
+  int o = bits - REGION_MINBITS;
+
+  if (!regioninit) region_setup();
+  while (o < REGION_ORDERS - 1){
+    unsigned long buddy = ((start - REGION_BASE) ^
+        ((unsigned long)1 << (o + REGION_MINBITS))) + REGION_BASE;
+    struct region_node_s **pn = &regionfree[o];
+    while (*pn && ((*pn)->start != buddy)) pn = &(*pn)->next;
+    if (!*pn) break;
+
+    /* Merge with the free buddy */
+    {
+      struct region_node_s *n = *pn;
+      *pn = n->next;
+      n->next = regionspare;
+      regionspare = n;
+      regionspares++;
+    }
+    if (buddy < start) start = buddy;
+    o++;
+  }
+  /* Cannot run out, REGION_NODES covers every free sub-space possible */
+  region_push(o, start);
+}
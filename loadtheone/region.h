@@ -0,0 +1,66 @@
+/**
+ * \file region.h
+ * \author Leendert van Duijn, UvA
+ *
+ * \brief Buddy allocator for process address sub-spaces.
+ *
+ * The functions keep unlocked state, callers serialize them on the pid
+ * allocation node.
+ **/
+
+#ifndef H_REGION
+#define H_REGION
+
+#include "loader_api.h"
+
+#ifndef REGION_BASE
+/** Start of the managed address range, above the loader's own sub-space */
+#define REGION_BASE (base_off + base_progmaxsize)
+#endif /* REGION_BASE */
+
+#ifndef REGION_TOPBITS
+/** Size of the managed address range, as address bits */
+#define REGION_TOPBITS 51
+#endif /* REGION_TOPBITS */
+
+#ifndef REGION_MINBITS
+/** Smallest sub-space handed out, as address bits */
+#define REGION_MINBITS 28
+#endif /* REGION_MINBITS */
+
+/** Number of sub-space sizes */
+#define REGION_ORDERS (REGION_TOPBITS - REGION_MINBITS + 1)
+
+#ifndef REGION_NODES
+/**
+ * Free list entries available for split sub-spaces. Every free sub-space
+ * has a split parent, an ancestor of some taken one, and no two share it.
+ * A pid holds at most two sub-spaces, its own and a stale one on its way
+ * back, so this covers every split possible.
+ **/
+#define REGION_NODES (2 * MAXPROCS * REGION_ORDERS + 1)
+#endif /* REGION_NODES */
+
+/**
+ * Address bits of the smallest sub-space holding bytes.
+ * \param bytes Requested size.
+ * \return Address bits, at least REGION_MINBITS.
+ **/
+int region_bits(unsigned long bytes);
+
+/**
+ * Takes a sub-space, splitting larger free ones as needed.
+ * \param bits Size as address bits.
+ * \param start Receives the start address, aligned to the size.
+ * \return 0 on success, -1 when out of address space.
+ **/
+int region_alloc(int bits, unsigned long *start);
+
+/**
+ * Returns a sub-space, merging it with its free buddy.
+ * \param start Start address from region_alloc.
+ * \param bits Size as passed to region_alloc.
+ **/
+void region_free(unsigned long start, int bits);
+
+#endif /* H_REGION */
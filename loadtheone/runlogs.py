@@ -1,6 +1,6 @@
 #!/usr/bin/env python
 import os
-from pylab import plot,figure,subplot,savefig,log,legend
+from pylab import plot,figure,subplot,savefig,log,legend,bar,xticks,title
 
 #
 # Leendert van Duijn
@@ -30,9 +30,19 @@ def grep(starr, strm):
       a.append(b)
   return a
 
+def clocksversion(strd):
+  """ Version of a Clocks record, '<Clocks>' is version 1, '<Clocks vN>' is N """
+  start = strd.index("<Clocks") + len("<Clocks")
+  tag = strd[start:strd.index(">", start)].strip()
+  if tag.startswith("v"):
+    return int(tag[1:])
+  return 1
+
 def converty(strd):
-  """ Turns the string form '<Clocks>?,?,?...</Clocks>' into an array of floats """
-  start = strd.index("<Clocks>") + len("<Clocks>")
+  """ Turns the string form '<Clocks>?,?,?...</Clocks>' into an array of floats,
+  versioned records ('<Clocks vN>') are accepted as well """
+  start = strd.index("<Clocks")
+  start = strd.index(">", start) + 1
   end = strd.index("</Clocks>")
   strp = strd[start:end]
   #print(strp)
@@ -61,6 +71,28 @@ leg = (
 "TicksToEnd",
 "TicksToCleaned"
 )
+
+#Fields following the above in version 2 records, the TicksToDetach breakdown
+phaseleg = (
+"Open",
+"Read",
+"Check",
+"Pid",
+"Reserve",
+"Copy",
+"Scan",
+"Reloc",
+"Args"
+)
+
+#Fields following the phases in version 3 records, counters over main
+perfleg = (
+"Cycles",
+"Instructions",
+"Loads",
+"Stores",
+"L1LinesLoaded"
+)
 def plotmad(arr_fn):
   """
   Plot an image,
@@ -83,7 +115,7 @@ def plotmad(arr_fn):
     filt = grep(data, "Clock")
     if (len(filt) < 2):
       return
-    res = map(converty, filt)
+    res = map(lambda x:converty(x)[0:len(leg)], filt)
     resp = perent(res)
     arr_resp.append((fn,resp))
 
@@ -111,6 +143,73 @@ def plotmad(arr_fn):
   if 0 < len(arr_resp):
     savefig("imgs/" + fname + ".png")
 
+def plotphases(arr_fn):
+  """
+  Plot the TicksToDetach breakdown,
+  feed this an array of filenames as for plotmad,
+  for each phase the mean ticks per file are drawn as adjacent bars,
+  only version 2 records carry phases, files without any are skipped
+  """
+  global i_plotnum
+  fname = "phases_"
+  figure(i_plotnum, figsize=(15,8))
+  i_plotnum += 1
+
+  arr_mean = list()
+  for fn in arr_fn:
+    data = ops("./logs/"+ fn + ".log")
+    filt = filter(lambda x:clocksversion(x) >= 2, grep(data, "<Clocks"))
+    if (len(filt) < 1):
+      continue
+    fname += fn
+    res = map(lambda x:converty(x)[len(leg):len(leg) + len(phaseleg)], filt)
+    resp = perent(res)
+    arr_mean.append((fn, map(lambda x:sum(x)/len(x), resp)))
+
+  width = 0.8 / max(1, len(arr_mean))
+  int_fign = 0
+  for fn, means in arr_mean:
+    bar(map(lambda x:x + int_fign * width, range(len(means))), means, width, label=fn,
+        color="bgrcmyk"[int_fign % 7])
+    int_fign += 1
+
+  if 0 < len(arr_mean):
+    xticks(map(lambda x:x + 0.4, range(len(phaseleg))), phaseleg)
+    title("Mean ticks per load phase")
+    legend(frameon=False,shadow=False, loc="best")
+    savefig("imgs/" + fname + ".png")
+
+def plotperf(arr_fn):
+  """
+  Plot the performance counters per process,
+  feed this an array of filenames as for plotmad,
+  only version 3 records carry counters, files without any are skipped
+  """
+  global i_plotnum
+  fname = "perf_"
+  figure(i_plotnum, figsize=(15,15))
+  i_plotnum += 1
+
+  fig = ("x-", "o-", "+-")
+  off = len(leg) + len(phaseleg)
+  int_fign = 0
+  for fn in arr_fn:
+    data = ops("./logs/"+ fn + ".log")
+    filt = filter(lambda x:clocksversion(x) >= 3, grep(data, "<Clocks"))
+    if (len(filt) < 2):
+      continue
+    fname += fn
+    res = map(lambda x:converty(x)[off:off + len(perfleg)], filt)
+    resp = perent(res)
+    for a in range(len(resp)):
+      subplot(3,2,a+1)
+      plot(resp[a],fig[int_fign % len(fig)], label=fn)
+      legend(frameon=False,shadow=False,title=perfleg[a], loc="best")
+    int_fign += 1
+
+  if 0 < int_fign:
+    savefig("imgs/" + fname + ".png")
+
 #Run on several input files, and combinations
 plotmad(["nulls"])
 plotmad(["nulls_noL2"])
@@ -118,6 +217,13 @@ plotmad(["nulls_noL2","nulls"])
 plotmad(["bulksec"])
 plotmad(["bulksec_noL2"])
 plotmad(["bulksec_noL2", "bulksec"])
+plotmad(["bulksec_color", "bulksec"])
+plotmad(["bulksec_color_noL2", "bulksec_noL2"])
+plotmad(["bulksec_trace", "bulksec"])
+plotmad(["treesec"])
+plotmad(["treesec", "bulksec"])
+plotmad(["asyncsec", "bulksec"])
+plotmad(["nulls_pool", "nulls"])
 plotmad(["bulktest"])
 plotmad(["cory"])
 plotmad(["funn"])
@@ -129,4 +235,9 @@ plotmad(["sparmy_noL2"])
 plotmad(["spawny"])
 plotmad(["tiny"])
 plotmad(["tshared"])
-
+plotphases(["bulksec", "bulksec_noL2"])
+plotphases(["nulls", "nulls_noL2"])
+plotphases(["treesec", "asyncsec"])
+plotperf(["nulls", "nulls_noL2"])
+plotperf(["bulksec", "bulksec_noL2"])
+plotperf(["sparmy", "sparmy_noL2"])
@@ -0,0 +1,113 @@
+/**
+ * \file sched.c
+ * \brief File housing the core placement engine.
+ *  Leendert van Duijn
+ *  UvA
+ *
+ *  Keeps a count of live processes per core, and picks the least loaded
+ *  place for processes which requested any place (core_start -1).
+ *
+ **/
+
+#include "sched.h"
+
+/** Live processes per managed core */
+static int coreload[SCHED_NCORES];
+
+/** Where the next search starts, rotates so equal loads spread out */
+static int cursor = 0;
+
+/** \brief Load of a place, cores outside the managed range count as busy.
+ * \param start First core.
+ * \param size Number of cores.
+ * \return Summed load.
+ **/
+static int place_load(int start, int size){
+  int i;
+  int sum = 0;
+  for (i=start;i<start+size;i++){
+    if ((i < SCHED_FIRSTCORE) || (i >= SCHED_FIRSTCORE + SCHED_NCORES)){
+      sum += SCHED_NCORES;
+    } else {
+      sum += coreload[i - SCHED_FIRSTCORE];
+    }
+  }
+  return sum;
+}
+
+/** \brief Overlap test.
+ * \return True if the two places share a core.
+ **/
+static int place_overlaps(int a, int asize, int b, int bsize){
+  return (b >= 0) && (a < b + bsize) && (b < a + asize);
+}
+
+int sched_placesize(int size){
+  int s = 1;
+
+  /* Place sizes are powers of two, aligned to their size */
+  while ((s < size) && (s < SCHED_NCORES)) s <<= 1;
+  return s;
+}
+
+int sched_pick(int size, const int *affinity, int naffinity,
+               int avoid_start, int avoid_size){
+  int s = sched_placesize(size);
+  int i;
+  int best = -1;
+  int bestload = 0;
+  int bestavoided = 1;
+
+  if (affinity && (naffinity > 0)){
+    for (i=0;i<naffinity;i++){
+      int c = affinity[(i + cursor) % naffinity];
+      int load = place_load(c, s);
+      int avoided = place_overlaps(c, s, avoid_start, avoid_size);
+      if ((best == -1) || (avoided < bestavoided) ||
+          ((avoided == bestavoided) && (load < bestload))){
+        best = c;
+        bestload = load;
+        bestavoided = avoided;
+      }
+    }
+  } else {
+    int nplaces = SCHED_NCORES / s;
+    for (i=0;i<nplaces;i++){
+      int c = SCHED_FIRSTCORE + ((i + cursor) % nplaces) * s;
+      int load = place_load(c, s);
+      int avoided = place_overlaps(c, s, avoid_start, avoid_size);
+      if ((best == -1) || (avoided < bestavoided) ||
+          ((avoided == bestavoided) && (load < bestload))){
+        best = c;
+        bestload = load;
+        bestavoided = avoided;
+      }
+    }
+  }
+  cursor++;
+  return best;
+}
+
+void sched_occupy(int start, int size, int delta){
+  int i;
+  if (size < 1) size = 1;
+  for (i=start;i<start+size;i++){
+    if ((i >= SCHED_FIRSTCORE) && (i < SCHED_FIRSTCORE + SCHED_NCORES)){
+      coreload[i - SCHED_FIRSTCORE] += delta;
+    }
+  }
+}
+
+int sched_load(int core){
+  if ((core < SCHED_FIRSTCORE) || (core >= SCHED_FIRSTCORE + SCHED_NCORES)) return -1;
+  return coreload[core - SCHED_FIRSTCORE];
+}
+
+int sched_idlest(void){
+  int i;
+  int best = 0;
+  for (i=1;i<SCHED_NCORES;i++){
+    if (coreload[i] < coreload[best]) best = i;
+  }
+  return SCHED_FIRSTCORE + best;
+}
@@ -0,0 +1,65 @@
+/**
+ * \file sched.h
+ * \author Leendert van Duijn, UvA
+ *
+ * \brief Core placement for processes started without an explicit place.
+ *
+ * The functions keep unlocked state, callers serialize them on the pid
+ * allocation node.
+ **/
+
+#ifndef H_SCHED
+#define H_SCHED
+
+#ifndef SCHED_FIRSTCORE
+/** First core handed out by the placement engine */
+#define SCHED_FIRSTCORE 64
+#endif /* SCHED_FIRSTCORE */
+
+#ifndef SCHED_NCORES
+/** Number of cores handed out by the placement engine */
+#define SCHED_NCORES 64
+#endif /* SCHED_NCORES */
+
+/**
+ * \param size Requested number of cores.
+ * \return Number of cores of the place sched_pick hands out for size, the
+ * size to occupy and release.
+ **/
+int sched_placesize(int size);
+
+/**
+ * Picks the least loaded place of size cores.
+ * \param size Requested number of cores, rounded as sched_placesize.
+ * \param affinity If set, the only cores considered as place start.
+ * \param naffinity Number of entries in affinity.
+ * \param avoid_start Start of a place to stay away from, or -1.
+ * \param avoid_size Size of the place to stay away from.
+ * \return First core of the picked place.
+ **/
+int sched_pick(int size, const int *affinity, int naffinity,
+               int avoid_start, int avoid_size);
+
+/**
+ * Notes processes arriving at or leaving from a place.
+ * Cores outside of the managed range are ignored.
+ * \param start First core of the place.
+ * \param size Number of cores of the place.
+ * \param delta +1 on arrival, -1 on departure.
+ **/
+void sched_occupy(int start, int size, int delta);
+
+/**
+ * \param core Which core.
+ * \return Number of live processes placed on core, -1 if not managed.
+ **/
+int sched_load(int core);
+
+/**
+ * Finds the core with the fewest live processes.
+ * Reads without the lock, the answer is only a hint for background work.
+ * \return The least loaded managed core.
+ **/
+int sched_idlest(void);
+
+#endif /* H_SCHED */
@@ -0,0 +1,40 @@
+/**
+ * \file stats.c
+ * \brief File housing the loader statistics.
+ *  Leendert van Duijn
+ *  UvA
+ *
+ *  Nothing here takes a lock, writers never share a counter. Entry 0 of the
+ *  shards is the exception, loads failing before they got a pid share it
+ *  with the blocks the loader reserves for itself, so those can be
+ *  undercounted when happening at the very same time.
+ *
+ **/
+
+#include <string.h>
+
+#include "ELF.h"
+#include "loader.h"
+#include "stats.h"
+
+struct stats_shard_s stats_shards[MAXPROCS];
+
+struct loader_stats_s stats_places;
+
+void loader_stats(struct loader_stats_s *out){
+  int i, r;
+
+  *out = stats_places;
+  for (i=0;i<MAXPROCS;i++){
+    const struct stats_shard_s *s = &stats_shards[i];
+    out->loads_started += s->loads_started;
+    out->loads_failed += s->loads_failed;
+    out->bytes_read += s->bytes_read;
+    out->bytes_copied += s->bytes_copied;
+    out->bytes_zeroed += s->bytes_zeroed;
+    out->bytes_requested += s->bytes_requested;
+    out->bytes_reserved += s->bytes_reserved;
+    for (r=0;r<STATS_RELOCTYPES;r++) out->relocs[r] += s->relocs[r];
+    out->symbols += s->symbols;
+  }
+}
@@ -0,0 +1,57 @@
+/**
+ * \file stats.h
+ * \author Leendert van Duijn, UvA
+ *
+ * \brief Loader statistics, in counters with a single writer each.
+ *
+ * Load path counters are kept per pid, the pid being loaded or reaped has a
+ * single thread working on it. Counters of the exclusive places are kept
+ * once and only written on their place. A read sums everything, unlocked.
+ **/
+
+#ifndef H_STATS
+#define H_STATS
+
+#include "loader_api.h"
+
+/** Counters of the load path, one set per pid */
+struct stats_shard_s {
+  /** As loader_stats_s */
+  unsigned long loads_started;
+  /** As loader_stats_s */
+  unsigned long loads_failed;
+  /** As loader_stats_s */
+  unsigned long bytes_read;
+  /** As loader_stats_s */
+  unsigned long bytes_copied;
+  /** As loader_stats_s */
+  unsigned long bytes_zeroed;
+  /** As loader_stats_s */
+  unsigned long bytes_requested;
+  /** As loader_stats_s */
+  unsigned long bytes_reserved;
+  /** As loader_stats_s */
+  unsigned long relocs[STATS_RELOCTYPES];
+  /** As loader_stats_s */
+  unsigned long symbols;
+};
+
+/** Load path counters, by pid, entry 0 for work before a pid exists */
+extern struct stats_shard_s stats_shards[];
+
+/**
+ * Counters of the exclusive places: pages on MEMCORE, prints on PRINTCORE,
+ * pids on the pid lock. The load path fields stay 0.
+ **/
+extern struct loader_stats_s stats_places;
+
+/** Adds N to Field of the counters of Pid */
+#define STAT_ADD(Pid, Field, N) (stats_shards[(Pid)].Field += (N))
+
+/**
+ * Sums all counters.
+ * \param out Receives the statistics.
+ **/
+void loader_stats(struct loader_stats_s *out);
+
+#endif /* H_STATS */
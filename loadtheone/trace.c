@@ -0,0 +1,159 @@
+/**
+ * \file trace.c
+ * \brief File housing the binary event ring.
+ *  Leendert van Duijn
+ *  UvA
+ *
+ *  Only the head counter is serialized, on the trace place. A writer fills
+ *  its slots after the reservation returns and sets the id last, so a dump
+ *  taken meanwhile shows the slot as unused instead of half written.
+ *
+ **/
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <svp/mgsim.h>
+#include <svp/abort.h>
+
+#include "ELF.h"
+#include "loader.h"
+#include "trace.h"
+
+/** The ring, indexed by sequence number modulo TRACE_SIZE */
+static struct trace_ev_s tracering[TRACE_SIZE];
+
+/** Events ever reserved, only touched on the trace place */
+static unsigned long tracehead = 0;
+
+/** Rings of the exclusive places, each only written on its place */
+static struct trace_ev_s lockrings[lock_count][TRACE_LOCKSIZE];
+
+/** Events ever recorded per exclusive place */
+static unsigned long lockheads[lock_count];
+
+char *trace_path = NULL;
+
+/* Reservation */
+sl_def(sltrace_reserve_fn,, sl_glparm(int, n), sl_glparm(unsigned long*, seq)){
+  *sl_getp(seq) = tracehead;
+  tracehead += sl_getp(n);
+}
+sl_enddef
+
+/** \brief Events a ring holds.
+ * \param head Events ever written.
+ * \param size Slots of the ring.
+ * \return Number of events.
+ **/
+static unsigned long trace_held(unsigned long head, unsigned long size){
+  return (head < size) ? head : size;
+}
+
+/** \brief Writes the events of a ring, oldest first.
+ * \param fd The dump.
+ * \param ring The ring.
+ * \param head Events ever written.
+ * \param size Slots of the ring.
+ * \return 0 on success.
+ **/
+static int trace_write(int fd, struct trace_ev_s *ring, unsigned long head,
+                       unsigned long size){
+  unsigned long n = trace_held(head, size);
+  unsigned long wrap = (head - n) % size;
+  ssize_t ok = 0;
+
+  /* In at most two pieces */
+  if (wrap + n > size){
+    size_t lo = (size - wrap) * sizeof(struct trace_ev_s);
+    size_t hi = (n - (size - wrap)) * sizeof(struct trace_ev_s);
+    ok += write(fd, &ring[wrap], lo) - (ssize_t)lo;
+    ok += write(fd, &ring[0], hi) - (ssize_t)hi;
+  } else {
+    size_t all = n * sizeof(struct trace_ev_s);
+    ok += write(fd, &ring[wrap], all) - (ssize_t)all;
+  }
+  return ok ? -1 : 0;
+}
+
+/* Dump, no reservation gets in between header and events */
+sl_def(sltrace_dump_fn,, sl_glparm(int, fd), sl_glparm(int*, res)){
+  int fd = sl_getp(fd);
+  struct trace_hdr_s hdr;
+  unsigned long heads[lock_count];
+  int ok = 0;
+  int l;
+
+  memcpy(hdr.magic, "LTRC", 4);
+  hdr.version = TRACE_VERSION;
+  hdr.head = tracehead;
+  hdr.size = trace_held(tracehead, TRACE_SIZE);
+  for (l=0;l<lock_count;l++){
+    /* The places keep going, the header counts what is written */
+    heads[l] = lockheads[l];
+    hdr.size += trace_held(heads[l], TRACE_LOCKSIZE);
+  }
+
+  if (write(fd, &hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr)) ok = -1;
+  /* The shared ring, then those of the places, each oldest first */
+  ok |= trace_write(fd, tracering, tracehead, TRACE_SIZE);
+  for (l=0;l<lock_count;l++){
+    ok |= trace_write(fd, lockrings[l], heads[l], TRACE_LOCKSIZE);
+  }
+  *sl_getp(res) = ok;
+}
+sl_enddef
+
+unsigned long trace_reserve(int n){
+  unsigned long seq = 0;
+  sl_create(, MAKE_CLUSTER_ADDR(TRACE_CORE, 1) ,,,,, sl__exclusive, sltrace_reserve_fn,
+      sl_glarg(int, n, n), sl_glarg(unsigned long*, seq, &seq));
+  sl_sync();
+  return seq;
+}
+
+void trace_put(unsigned long seq, int id, int pid, int core,
+               unsigned long tick, unsigned long payload){
+  struct trace_ev_s *ev = &tracering[seq % TRACE_SIZE];
+  ev->id = tr_none;
+  ev->pid = pid;
+  ev->core = core;
+  ev->tick = tick;
+  ev->payload = payload;
+  ev->id = id;
+}
+
+void trace_event(int id, int pid, int core,
+                 unsigned long tick, unsigned long payload){
+  trace_put(trace_reserve(1), id, pid, core, tick, payload);
+}
+
+void trace_lock(int lock, unsigned long entry, unsigned long wait,
+                unsigned long hold){
+  struct trace_ev_s *ev = &lockrings[lock][lockheads[lock] % TRACE_LOCKSIZE];
+  if (wait > 0xfffffffful) wait = 0xfffffffful;
+  if (hold > 0xfffffffful) hold = 0xfffffffful;
+  ev->id = tr_none;
+  ev->pid = lock;
+  ev->core = -1;
+  ev->tick = entry;
+  ev->payload = (wait << 32) | hold;
+  ev->id = tr_lock;
+  lockheads[lock]++;
+}
+
+int trace_dump(void){
+  int res = -1;
+  int fd;
+
+  if (!trace_path) return -1;
+  fd = open(trace_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) return -1;
+
+  sl_create(, MAKE_CLUSTER_ADDR(TRACE_CORE, 1) ,,,,, sl__exclusive, sltrace_dump_fn,
+      sl_glarg(int, fd, fd), sl_glarg(int*, res, &res));
+  sl_sync();
+  close(fd);
+  return res;
+}
@@ -0,0 +1,135 @@
+/**
+ * \file trace.h
+ * \author Leendert van Duijn, UvA
+ *
+ * \brief Binary event ring for loader measurements.
+ *
+ * Events are fixed size records, a writer reserves its slots in one trip to
+ * the trace place and fills them itself, nothing is formatted or printed.
+ * Exclusive places record their requests in rings of their own, needing
+ * no reservation at all.
+ * The ring is written to the trace file in one block, decode it with
+ * tracedecode.py.
+ **/
+
+#ifndef H_TRACE
+#define H_TRACE
+
+#ifndef TRACE_CORE
+/** Core serializing slot reservation */
+#define TRACE_CORE 4
+#endif /* TRACE_CORE */
+
+#ifndef TRACE_SIZE
+/** Events kept, older ones are overwritten, a power of two */
+#define TRACE_SIZE 4096
+#endif /* TRACE_SIZE */
+
+#ifndef TRACE_LOCKSIZE
+/** Events kept per exclusive place, a power of two */
+#define TRACE_LOCKSIZE 1024
+#endif /* TRACE_LOCKSIZE */
+
+/** Format version written in the dump header */
+#define TRACE_VERSION 2
+
+/**
+ * Event ids, a timed process is a block: tr_proc, ph_count tr_phase events,
+ * pf_count tr_perf events, tr_detach, tr_end and tr_cleaned.
+ **/
+enum e_trace {
+  /**Unused or unfinished slot*/
+  tr_none = 0,
+  /**Process start, tick createtick, payload core_size*/
+  tr_proc,
+  /**Load phase, tick the ticks spent, payload the e_phase*/
+  tr_phase,
+  /**Tick detachtick*/
+  tr_detach,
+  /**Tick lasttick*/
+  tr_end,
+  /**Tick cleaneduptick, closes the block*/
+  tr_cleaned,
+  /**Counter change, tick the change, payload the e_perf*/
+  tr_perf,
+  /**Request on an exclusive place, pid the e_lock, tick the entry,
+   * payload the wait in the upper and the hold in the lower 32 bits*/
+  tr_lock
+};
+
+/** A single event, as stored and dumped */
+struct trace_ev_s {
+  /** An e_trace, written last */
+  unsigned short id;
+  /** Process the event is about */
+  unsigned short pid;
+  /** Core of the process, -1 if unplaced */
+  int core;
+  /** Clock value */
+  unsigned long tick;
+  /** Event specific */
+  unsigned long payload;
+};
+
+/** Precedes the events in a dump */
+struct trace_hdr_s {
+  /** "LTRC" */
+  char magic[4];
+  /** TRACE_VERSION, tells the byte order as well */
+  unsigned int version;
+  /** Events ever reserved, the dump holds the last TRACE_SIZE of them */
+  unsigned long head;
+  /** Slots in the dump */
+  unsigned long size;
+};
+
+/** File the ring is dumped to, tracing is off while unset */
+extern char *trace_path;
+
+/**
+ * Reserves consecutive slots.
+ * \param n Number of events, at most TRACE_SIZE.
+ * \return Sequence number of the first slot.
+ **/
+unsigned long trace_reserve(int n);
+
+/**
+ * Fills a reserved slot.
+ * \param seq Sequence number from trace_reserve, plus the offset in the block.
+ * \param id The e_trace.
+ * \param pid Process.
+ * \param core Core of the process.
+ * \param tick Clock value.
+ * \param payload Event specific.
+ **/
+void trace_put(unsigned long seq, int id, int pid, int core,
+               unsigned long tick, unsigned long payload);
+
+/**
+ * Records a single event.
+ * \param id The e_trace.
+ * \param pid Process.
+ * \param core Core of the process.
+ * \param tick Clock value.
+ * \param payload Event specific.
+ **/
+void trace_event(int id, int pid, int core,
+                 unsigned long tick, unsigned long payload);
+
+/**
+ * Records a request on an exclusive place, only from that place.
+ * \param lock The e_lock.
+ * \param entry Tick the family started.
+ * \param wait Ticks from request to entry.
+ * \param hold Ticks from entry to leaving.
+ **/
+void trace_lock(int lock, unsigned long entry, unsigned long wait,
+                unsigned long hold);
+
+/**
+ * Writes the rings to trace_path, replacing an earlier dump.
+ * \return 0 on success, -1 if tracing is off or the file failed.
+ **/
+int trace_dump(void);
+
+#endif /* H_TRACE */
@@ -0,0 +1,189 @@
+#!/usr/bin/env python
+import sys
+import struct
+import json
+
+#
+# Leendert van Duijn
+#
+# Script for turning a binary trace dump (see trace.h) into the
+# <Clocks> lines runlogs.py reads, usage:
+#   ./tracedecode.py trace.bin > ./logs/name.log
+# or into Chrome trace event JSON, for chrome://tracing or Perfetto:
+#   ./tracedecode.py --chrome trace.bin > name.json
+#
+
+#Layout of trace.h, a header followed by events
+hdrfmt = "4sIQQ"
+evfmt = "HHiQQ"
+
+#Event ids, as enum e_trace
+tr_none = 0
+tr_proc = 1
+tr_phase = 2
+tr_detach = 3
+tr_end = 4
+tr_cleaned = 5
+tr_perf = 6
+tr_lock = 7
+
+#Names of the exclusive places, as enum e_lock
+locknames = ("Pid", "Mem", "Print")
+
+#Names of the load phases, as enum e_phase
+phasenames = ("Open", "Read", "Check", "Pid", "Reserve", "Copy", "Scan",
+              "Reloc", "Args")
+
+#Phases run before the pid is allocated, they end at the create tick
+prepid = 4
+
+#Number of load phases, as ph_count
+phases = 9
+
+#Number of performance counters, as pf_count
+perfs = 5
+
+#Version of the Clocks record produced
+clocksversion = 3
+
+def readdump(fname):
+  """ Reads a dump, returns the header values and a list of event tuples """
+  fil = open(fname, "rb")
+  data = fil.read()
+  fil.close()
+  if data[0:4] != b"LTRC":
+    raise ValueError(fname + " is not a trace dump")
+
+  #The version, a small number, tells the byte order of the writer
+  order = "<"
+  if struct.unpack("<" + hdrfmt, data[0:struct.calcsize(hdrfmt)])[1] > 0xff:
+    order = ">"
+  hsize = struct.calcsize(order + hdrfmt)
+  esize = struct.calcsize(order + evfmt)
+  magic, version, head, size = struct.unpack(order + hdrfmt, data[0:hsize])
+  events = list()
+  for i in range(size):
+    off = hsize + i * esize
+    if off + esize > len(data):
+      break
+    events.append(struct.unpack(order + evfmt, data[off:off + esize]))
+  return (version, head, size, events)
+
+def records(events):
+  """ Groups event blocks into Clocks records, incomplete blocks are skipped """
+  rec = None
+  for ev in events:
+    evid, pid, core, tick, payload = ev
+    if evid == tr_lock:
+      #Recorded in rings of their own, never inside a block
+      continue
+    if evid == tr_proc:
+      rec = {"pid":pid, "core":core, "size":payload, "create":tick,
+             "phases":[0] * phases, "perf":[0] * perfs}
+    elif rec is None or pid != rec["pid"]:
+      #Overwritten start or an unfinished block
+      rec = None
+    elif evid == tr_phase and payload < phases:
+      rec["phases"][payload] = tick
+    elif evid == tr_perf and payload < perfs:
+      #Written from a signed long
+      if tick >= 1 << 63:
+        tick -= 1 << 64
+      rec["perf"][payload] = tick
+    elif evid == tr_detach:
+      rec["detach"] = tick
+    elif evid == tr_end:
+      rec["end"] = tick
+    elif evid == tr_cleaned:
+      rec["cleaned"] = tick
+      if "detach" in rec and "end" in rec:
+        yield rec
+      rec = None
+    else:
+      rec = None
+
+def clocksline(rec):
+  """ Formats a record as locked_delbase prints it """
+  fields = [rec["pid"], rec["core"], rec["size"], rec["create"],
+            rec["detach"] - rec["create"],
+            rec["end"] - rec["create"],
+            rec["cleaned"] - rec["create"]] + rec["phases"] + rec["perf"]
+  return "<Clocks v%d>%s</Clocks>" % (clocksversion, ",".join(map(str, fields)))
+
+def span(name, track, thread, start, dur, args):
+  """ A complete event, times in ticks """
+  return {"name":name, "ph":"X", "pid":track, "tid":thread,
+          "ts":start, "dur":dur, "args":args}
+
+def chrome(events):
+  """
+  Builds Chrome trace events: track 1 holds a thread per core with the load
+  phases and run time of its processes, track 2 a thread per exclusive place
+  with its hold times, the waits for it are async spans as they overlap
+  """
+  out = list()
+  cores = set()
+  out.append({"name":"process_name", "ph":"M", "pid":1, "args":{"name":"Cores"}})
+  out.append({"name":"process_name", "ph":"M", "pid":2,
+              "args":{"name":"Exclusive places"}})
+  for rec in records(events):
+    core = rec["core"]
+    cores.add(core)
+    args = {"pid":rec["pid"]}
+    #Phases are durations, laid out in order around the create tick
+    t = rec["create"] - sum(rec["phases"][0:prepid])
+    for ph in range(len(phasenames)):
+      dur = rec["phases"][ph]
+      if dur > 0:
+        out.append(span(phasenames[ph], 1, core, t, dur, args))
+      t += dur
+    out.append(span("Run %d" % rec["pid"], 1, core, rec["detach"],
+                    rec["end"] - rec["detach"], args))
+    out.append(span("Cleanup", 1, core, rec["end"],
+                    rec["cleaned"] - rec["end"], args))
+
+  waitid = 0
+  for ev in events:
+    evid, lock, core, tick, payload = ev
+    if evid != tr_lock or lock >= len(locknames):
+      continue
+    wait = payload >> 32
+    hold = payload & 0xffffffff
+    out.append(span("Hold", 2, lock, tick, hold, {}))
+    if wait > 0:
+      waitid += 1
+      out.append({"name":"Wait " + locknames[lock], "cat":"wait", "ph":"b",
+                  "id":waitid, "pid":2, "tid":lock, "ts":tick - wait})
+      out.append({"name":"Wait " + locknames[lock], "cat":"wait", "ph":"e",
+                  "id":waitid, "pid":2, "tid":lock, "ts":tick})
+
+  for core in sorted(cores):
+    out.append({"name":"thread_name", "ph":"M", "pid":1, "tid":core,
+                "args":{"name":"Core %d" % core}})
+  for lock in range(len(locknames)):
+    out.append({"name":"thread_name", "ph":"M", "pid":2, "tid":lock,
+                "args":{"name":locknames[lock]}})
+  #Ticks are shown as if they were microseconds
+  return {"traceEvents":out, "displayTimeUnit":"ms"}
+
+if __name__ == "__main__":
+  args = sys.argv[1:]
+  tochrome = False
+  if len(args) > 0 and args[0] == "--chrome":
+    tochrome = True
+    args = args[1:]
+  if len(args) < 1:
+    sys.stderr.write("usage: tracedecode.py [--chrome] dump [dump...]\n")
+    sys.exit(1)
+  allevents = list()
+  for fname in args:
+    version, head, size, events = readdump(fname)
+    if head > size:
+      sys.stderr.write("%s: older events overwritten\n" % fname)
+    if tochrome:
+      allevents += events
+    else:
+      for rec in records(events):
+        print(clocksline(rec))
+  if tochrome:
+    print(json.dumps(chrome(allevents)))